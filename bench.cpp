@@ -0,0 +1,398 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include "relation.h"
+#include "simdKernels.h"
+
+using namespace std;
+
+/*
+ * Benchmark driver for the join operators.
+ *
+ * Every run generates a chain of k binary relations R1(A1, A2), ..., Rk(Ak, Ak+1) of "scale" tuples each from
+ * a fixed seed, then times naturalJoin, semiJoin and project on R1 and R2 and executeLineJoin and
+ * executeLineJoinByChaining on the whole chain. Each operator runs "warmup" untimed times and "trials" timed
+ * times; the median, 95th percentile, minimum and mean wall-clock times are reported as JSON or CSV.
+ * --simd caps the instruction set of the batch kernels (see simdKernels) to compare their implementations.
+ *
+ * Usage: bench [--scale N] [--k K] [--dist uniform|zipf|adversarial|fk|all] [--seed S] [--warmup W]
+ *              [--trials T] [--ops op1,op2,...] [--zipf S] [--fanout F] [--format json|csv] [--output FILE]
+ *              [--simd scalar|sse4.2|avx2]
+ */
+
+/*
+ * Benchmark parameters and their defaults.
+ */
+struct benchConfig {
+    long long scale = 100000;
+    int k = 3;
+    vector<string> distributions{"uniform", "zipf", "adversarial", "fk"};
+    unsigned long long seed = 42;
+    int warmup = 1;
+    int trials = 5;
+    vector<string> ops{"naturalJoin", "semiJoin", "project", "executeLineJoin", "executeLineJoinByChaining"};
+    double zipfExponent = 1.1;
+    int fanout = 100;
+    string format = "json";
+    string output;
+    simdKernels::level simd = simdKernels::getSupportedLevel();
+};
+
+/*
+ * Timings of one operator on one data set, in microseconds.
+ */
+struct benchResult {
+    string op;
+    string distribution;
+    long long resultRows;
+    vector<double> times;
+};
+
+/*
+ * Zipf sampler over [0, n) with P(i) proportional to 1 / (i+1)^s, by rejection-inversion
+ * (Hormann and Derflinger), so no table over the domain is needed.
+ */
+class zipfSampler {
+    public:
+        zipfSampler(long long n, double s) : n(n), s(s) {
+            this->hIntegralX1 = this->hIntegral(1.5) - 1;
+            this->hIntegralN = this->hIntegral(n + 0.5);
+            this->threshold = 2 - this->hIntegralInverse(this->hIntegral(2.5) - this->h(2));
+        }
+
+        template<typename G>
+        long long operator()(G& gen) {
+            uniform_real_distribution<double> uniform(0, 1);
+
+            while (true) {
+                double u = this->hIntegralN + uniform(gen) * (this->hIntegralX1 - this->hIntegralN);
+                double x = this->hIntegralInverse(u);
+                long long k = max(1LL, min(this->n, (long long)(x + 0.5)));
+
+                if (k - x <= this->threshold || u >= this->hIntegral(k + 0.5) - this->h(k)) {
+                    return k - 1;
+                }
+            }
+        }
+
+    private:
+        double h(double x) const {
+            return exp(-this->s * log(x));
+        }
+
+        double hIntegral(double x) const {
+            double logX = log(x);
+            return helper2((1 - this->s) * logX) * logX;
+        }
+
+        double hIntegralInverse(double x) const {
+            double t = max(-1.0, x * (1 - this->s));
+            return exp(helper1(t) * x);
+        }
+
+        // log(1 + x) / x and (exp(x) - 1) / x, accurate near 0
+        static double helper1(double x) {
+            return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+        }
+
+        static double helper2(double x) {
+            return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+        }
+
+        long long n;
+        double s;
+        double hIntegralX1;
+        double hIntegralN;
+        double threshold;
+};
+
+/*
+ * Builds relation i (0-based) of the chain from its two columns, shuffling the rows with the given engine.
+ */
+relation makeRelation(int i, trackedVector<int>& left, trackedVector<int>& right, mt19937_64& gen) {
+    for (long long r = left.size() - 1; r > 0; r--) {
+        long long other = uniform_int_distribution<long long>(0, r)(gen);
+        swap(left[r], left[other]);
+        swap(right[r], right[other]);
+    }
+
+    vector<string> attrs{"A" + to_string(i + 1), "A" + to_string(i + 2)};
+    relation res("R" + to_string(i + 1), attrs);
+    vector<trackedVector<int>> cols(2);
+    cols[0] = move(left);
+    cols[1] = move(right);
+    res.appendColumns(move(cols));
+    return res;
+}
+
+/*
+ * Generates the chain of config.k relations for one distribution:
+ *   uniform      both columns uniform over [0, scale)
+ *   zipf         like uniform, but the second column is Zipf-distributed with exponent config.zipfExponent,
+ *                so joins stay around scale tuples while a few keys receive most of the probes
+ *   adversarial  the pattern of problem 5: odd attributes hold ids and even attributes hold keys shared by
+ *                config.fanout ids, so every join on a key multiplies the intermediate result by the fanout,
+ *                while the last relation matches a single tuple and the final result stays tiny
+ *   fk           A1 is a key of R1 and Ai+1 a foreign key of Ri referencing the key Ai+1 of Ri+1,
+ *                so every join returns exactly scale tuples
+ */
+vector<relation> generateChain(const benchConfig& config, const string& distribution) {
+    int n = config.scale;
+    vector<relation> chain;
+
+    for (int i = 0; i < config.k; i++) {
+        mt19937_64 gen(config.seed * 1000003 + i);
+        trackedVector<int> left(n), right(n);
+
+        if (distribution == "uniform") {
+            uniform_int_distribution<int> uniform(0, n - 1);
+            for (int r = 0; r < n; r++) {
+                left[r] = uniform(gen);
+                right[r] = uniform(gen);
+            }
+        } else if (distribution == "zipf") {
+            uniform_int_distribution<int> uniform(0, n - 1);
+            zipfSampler zipf(n, config.zipfExponent);
+            for (int r = 0; r < n; r++) {
+                left[r] = uniform(gen);
+                right[r] = zipf(gen);
+            }
+        } else if (distribution == "adversarial") {
+            bool idFirst = i % 2 == 0;
+
+            for (int r = 0; r < n; r++) {
+                int id = r, key = r / config.fanout;
+                left[r] = idFirst ? id : key;
+                right[r] = idFirst ? key : id;
+            }
+
+            // the last relation only continues the chain through its first row
+            if (i == config.k - 1 && config.k > 1) {
+                for (int r = 1; r < n; r++) {
+                    left[r] = n + r;
+                }
+            }
+        } else if (distribution == "fk") {
+            uniform_int_distribution<int> uniform(0, n - 1);
+            for (int r = 0; r < n; r++) {
+                left[r] = r;
+                right[r] = uniform(gen);
+            }
+        } else {
+            throw std::invalid_argument("Unknown distribution " + distribution + "!");
+        }
+
+        chain.push_back(makeRelation(i, left, right, gen));
+    }
+
+    return chain;
+}
+
+/*
+ * Runs op config.warmup + config.trials times and records the timed trials.
+ */
+benchResult runBenchmark(const benchConfig& config, const string& op, const string& distribution,
+                         const vector<relation>& chain) {
+    benchResult res{op, distribution, 0, {}};
+    const relation& r1 = chain[0];
+    const relation& r2 = chain.size() > 1 ? chain[1] : chain[0];
+    string projected = r1.getAttributes()[1];
+
+    function<relation()> run;
+    if (op == "naturalJoin") {
+        run = [&]() { return r1.naturalJoin(r2); };
+    } else if (op == "semiJoin") {
+        run = [&]() { return r1.semiJoin(r2); };
+    } else if (op == "project") {
+        run = [&]() { return r1.project(projected); };
+    } else if (op == "executeLineJoin") {
+        run = [&]() { return relation::executeLineJoin(chain); };
+    } else if (op == "executeLineJoinByChaining") {
+        run = [&]() { return relation::executeLineJoinByChaining(chain); };
+    } else {
+        throw std::invalid_argument("Unknown operator " + op + "!");
+    }
+
+    for (int t = 0; t < config.warmup + config.trials; t++) {
+        auto start = chrono::steady_clock::now();
+        relation result = run();
+        double time = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+        res.resultRows = result.getRowCount();
+        if (t >= config.warmup) {
+            res.times.push_back(time);
+        }
+    }
+
+    return res;
+}
+
+/*
+ * Returns the q-quantile of the sorted times by the nearest-rank method; q = 0.5 gives the median
+ * (the mean of the two middle values for an even count).
+ */
+double quantile(const vector<double>& sorted, double q) {
+    if (q == 0.5 && sorted.size() % 2 == 0) {
+        return (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+    }
+    int rank = max(1, (int)ceil(q * sorted.size()));
+    return sorted[rank - 1];
+}
+
+void writeResults(const benchConfig& config, const vector<benchResult>& results, ostream& out) {
+    if (config.format == "csv") {
+        out << "op,distribution,scale,k,seed,warmup,trials,simd,result_rows,median_us,p95_us,min_us,mean_us" << endl;
+    } else {
+        out << "[" << endl;
+    }
+
+    for (int i = 0; i < results.size(); i++) {
+        const benchResult& res = results[i];
+        vector<double> sorted(res.times);
+        sort(sorted.begin(), sorted.end());
+
+        double mean = 0;
+        for (double time : sorted) {
+            mean += time / sorted.size();
+        }
+
+        if (config.format == "csv") {
+            out << res.op << "," << res.distribution << "," << config.scale << "," << config.k << ","
+                << config.seed << "," << config.warmup << "," << config.trials << ","
+                << simdKernels::getLevelName(config.simd) << "," << res.resultRows << ","
+                << quantile(sorted, 0.5) << "," << quantile(sorted, 0.95) << "," << sorted[0] << ","
+                << mean << endl;
+        } else {
+            out << "  {\"op\": \"" << res.op << "\", \"distribution\": \"" << res.distribution
+                << "\", \"scale\": " << config.scale << ", \"k\": " << config.k << ", \"seed\": " << config.seed
+                << ", \"warmup\": " << config.warmup << ", \"trials\": " << config.trials
+                << ", \"simd\": \"" << simdKernels::getLevelName(config.simd) << "\""
+                << ", \"result_rows\": " << res.resultRows << ", \"median_us\": " << quantile(sorted, 0.5)
+                << ", \"p95_us\": " << quantile(sorted, 0.95) << ", \"min_us\": " << sorted[0]
+                << ", \"mean_us\": " << mean << ", \"times_us\": [";
+            for (int t = 0; t < res.times.size(); t++) {
+                out << (t == 0 ? "" : ", ") << res.times[t];
+            }
+            out << "]}" << (i + 1 < results.size() ? "," : "") << endl;
+        }
+    }
+
+    if (config.format != "csv") {
+        out << "]" << endl;
+    }
+}
+
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream in(list);
+    string item;
+
+    while (getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+benchConfig parseArguments(int argc, char* argv[]) {
+    benchConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg + "!");
+        }
+        string val = argv[++i];
+
+        if (arg == "--scale") {
+            config.scale = stoll(val);
+        } else if (arg == "--k") {
+            config.k = stoi(val);
+        } else if (arg == "--dist") {
+            if (val != "all") {
+                config.distributions = splitList(val);
+            }
+        } else if (arg == "--seed") {
+            config.seed = stoull(val);
+        } else if (arg == "--warmup") {
+            config.warmup = stoi(val);
+        } else if (arg == "--trials") {
+            config.trials = stoi(val);
+        } else if (arg == "--ops") {
+            config.ops = splitList(val);
+        } else if (arg == "--zipf") {
+            config.zipfExponent = stod(val);
+        } else if (arg == "--fanout") {
+            config.fanout = stoi(val);
+        } else if (arg == "--format") {
+            config.format = val;
+        } else if (arg == "--output") {
+            config.output = val;
+        } else if (arg == "--simd") {
+            bool known = false;
+            for (simdKernels::level l : {simdKernels::scalar, simdKernels::sse42, simdKernels::avx2}) {
+                if (val == simdKernels::getLevelName(l)) {
+                    config.simd = l;
+                    known = true;
+                }
+            }
+            if (!known || config.simd > simdKernels::getSupportedLevel()) {
+                throw std::invalid_argument("Unsupported instruction set " + val + "!");
+            }
+        } else {
+            throw std::invalid_argument("Unknown option " + arg + "!");
+        }
+    }
+
+    if (config.scale < 1 || config.scale > INT_MAX || config.k < 1 || config.trials < 1 || config.warmup < 0
+        || config.fanout < 1 || (config.format != "json" && config.format != "csv")) {
+        throw std::invalid_argument("Invalid benchmark parameters!");
+    }
+
+    return config;
+}
+
+int main(int argc, char* argv[]) {
+    benchConfig config;
+
+    try {
+        config = parseArguments(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        cerr << "Usage: bench [--scale N] [--k K] [--dist uniform|zipf|adversarial|fk|all] [--seed S]"
+             << " [--warmup W] [--trials T] [--ops op1,op2,...] [--zipf S] [--fanout F] [--format json|csv]"
+             << " [--output FILE] [--simd scalar|sse4.2|avx2]" << endl;
+        return 1;
+    }
+
+    vector<benchResult> results;
+    simdKernels::setLevel(config.simd);
+
+    try {
+        for (const string& distribution : config.distributions) {
+            vector<relation> chain = generateChain(config, distribution);
+
+            for (const string& op : config.ops) {
+                cerr << "Running " << op << " on " << distribution << " data..." << endl;
+                results.push_back(runBenchmark(config, op, distribution, chain));
+            }
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (config.output.empty()) {
+        writeResults(config, results, cout);
+    } else {
+        ofstream out(config.output);
+        writeResults(config, results, out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include "bloomFilter.h"
+#include "joinHashTable.h"
+
+// odd multipliers picking one bit per word from the key hash
+static const unsigned int salts[8] = {
+        0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+        0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U
+};
+
+bloomFilter::bloomFilter() = default;
+
+/*
+ * Builds the filter over every row of the key columns, sized to roughly bitsPerKey bits per row.
+ */
+bloomFilter::bloomFilter(const vector<columnSpan>& keys, int bitsPerKey)
+        : bloomFilter(keys, nullptr, keys.empty() ? 0 : keys[0].size, bitsPerKey) {
+}
+
+/*
+ * Builds the filter over the given subset of rows only; a null rows stands for rows 0 .. rowCount - 1.
+ */
+bloomFilter::bloomFilter(const vector<columnSpan>& keys, const int* rows, int rowCount, int bitsPerKey) {
+    long long totalBits = max(1LL, (long long)rowCount * max(1, bitsPerKey));
+    this->blocks.assign((totalBits + 255) / 256, block{});
+
+    for (int i = 0; i < rowCount; i++) {
+        int row = rows == nullptr ? i : rows[i];
+        unsigned int h = joinHashTable::hashRow(keys, row);
+        block& b = this->blocks[this->blockIndex(h)];
+        unsigned int bits = remix(h);
+
+        for (int w = 0; w < 8; w++) {
+            b.words[w] |= 1U << ((bits * salts[w]) >> 27);
+        }
+    }
+}
+
+/*
+ * Returns false only if the key of row in probeKeys was never inserted.
+ */
+bool bloomFilter::mayContain(const vector<columnSpan>& probeKeys, int row) const {
+    if (this->blocks.empty()) {
+        return false;
+    }
+
+    unsigned int h = joinHashTable::hashRow(probeKeys, row);
+    const block& b = this->blocks[this->blockIndex(h)];
+    unsigned int bits = remix(h);
+
+    for (int w = 0; w < 8; w++) {
+        if ((b.words[w] & (1U << ((bits * salts[w]) >> 27))) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int bloomFilter::getSizeInBytes() const {
+    return this->blocks.size() * sizeof(block);
+}
+
+/*
+ * The high bits of the hash select the block; the bits inside it are derived from a remix of the hash.
+ */
+int bloomFilter::blockIndex(unsigned int h) const {
+    return ((unsigned long long)h * this->blocks.size()) >> 32;
+}
+
+/*
+ * Murmur3 finalizer, decorrelating the in-block bits from the high bits of h that chose the block.
+ */
+unsigned int bloomFilter::remix(unsigned int h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    return h;
+}
@@ -0,0 +1,38 @@
+#ifndef PROJECT_BLOOMFILTER_H
+#define PROJECT_BLOOMFILTER_H
+
+#include <vector>
+#include "columnSpan.h"
+#include "memoryTracker.h"
+
+using namespace std;
+
+/*
+ * Blocked Bloom filter over (possibly composite) join keys.
+ * Every key maps onto one 32-byte block and sets one bit in each of the block's eight 32-bit words, so an
+ * insert or a lookup touches a single cache line. Lookups never miss an inserted key; keys that were not
+ * inserted pass with a small probability (about 3% at 8 bits per key, under 0.1% at 16).
+ */
+class bloomFilter {
+    public:
+        bloomFilter();
+        bloomFilter(const vector<columnSpan>& keys, int bitsPerKey);
+        bloomFilter(const vector<columnSpan>& keys, const int* rows, int rowCount, int bitsPerKey);
+        bool mayContain(const vector<columnSpan>& probeKeys, int row) const;
+        int getSizeInBytes() const;
+
+    private:
+        /* private structs */
+        struct alignas(32) block {
+            unsigned int words[8];
+        };
+
+        int blockIndex(unsigned int h) const;
+
+        static unsigned int remix(unsigned int h);
+
+        /* properties */
+        trackedVector<block> blocks;
+};
+
+#endif //PROJECT_BLOOMFILTER_H
@@ -0,0 +1,17 @@
+#ifndef PROJECT_COLUMNSPAN_H
+#define PROJECT_COLUMNSPAN_H
+
+/*
+ * Read-only view over one contiguous column of a relation.
+ * Spans are invalidated by any call that inserts into or reshapes the relation.
+ */
+struct columnSpan {
+    const int* data;
+    int size;
+
+    const int* begin() const { return data; }
+    const int* end() const { return data + size; }
+    int operator[](int idx) const { return data[idx]; }
+};
+
+#endif //PROJECT_COLUMNSPAN_H
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "columnStats.h"
+
+columnStats::columnStats() {
+    this->count = 0;
+    this->minVal = INT_MAX;
+    this->maxVal = INT_MIN;
+    this->registers.assign(1 << hllBits, 0);
+    this->sketch.assign(sketchDepth * sketchWidth, 0);
+    this->minHitter = -1;
+    this->rngState = 0x2545F4914F6CDD1DULL;
+}
+
+void columnStats::add(int val) {
+    this->count++;
+    this->minVal = min(this->minVal, val);
+    this->maxVal = max(this->maxVal, val);
+
+    // HyperLogLog: the top bits pick a register, which keeps the longest run of leading zeros seen in the rest
+    unsigned long long h = mix((unsigned long long)(unsigned int)val);
+    unsigned int reg = h >> (64 - hllBits);
+    unsigned long long rest = (h << hllBits) | (1ULL << (hllBits - 1));
+    unsigned char rank = __builtin_clzll(rest) + 1;
+    this->registers[reg] = max(this->registers[reg], rank);
+
+    // Count-Min: one counter per row, the estimate is the smallest of them
+    unsigned int est = UINT_MAX;
+    for (int d = 0; d < sketchDepth; d++) {
+        unsigned int& counter = this->sketch[d * sketchWidth + (mix(h + d) & (sketchWidth - 1))];
+        counter++;
+        est = min(est, counter);
+    }
+
+    // heavy hitters: only values estimated above the weakest candidate can enter the candidate set
+    int hitterCount = this->heavyHitters.size();
+    if (hitterCount < heavyHitterCount || est > this->heavyHitters[this->minHitter].second) {
+        int pos = 0;
+        while (pos < hitterCount && this->heavyHitters[pos].first != val) {
+            pos++;
+        }
+
+        if (pos < hitterCount) {
+            this->heavyHitters[pos].second = est;
+        } else if (hitterCount < heavyHitterCount) {
+            this->heavyHitters.emplace_back(val, est);
+        } else {
+            this->heavyHitters[this->minHitter] = make_pair(val, (long long)est);
+        }
+
+        this->minHitter = 0;
+        for (int i = 1; i < this->heavyHitters.size(); i++) {
+            if (this->heavyHitters[i].second < this->heavyHitters[this->minHitter].second) {
+                this->minHitter = i;
+            }
+        }
+    }
+
+    // reservoir sampling (algorithm R)
+    if (this->sample.size() < sampleSize) {
+        this->sample.push_back(val);
+    } else {
+        this->rngState ^= this->rngState << 13;
+        this->rngState ^= this->rngState >> 7;
+        this->rngState ^= this->rngState << 17;
+        unsigned long long pos = this->rngState % this->count;
+
+        if (pos < sampleSize) {
+            this->sample[pos] = val;
+        }
+    }
+}
+
+long long columnStats::getCount() const {
+    return this->count;
+}
+
+/*
+ * Smallest value added, or INT_MAX if there is none.
+ */
+int columnStats::getMin() const {
+    return this->minVal;
+}
+
+/*
+ * Largest value added, or INT_MIN if there is none.
+ */
+int columnStats::getMax() const {
+    return this->maxVal;
+}
+
+double columnStats::estimateDistinct() const {
+    int m = 1 << hllBits;
+    double sum = 0;
+    int zeros = 0;
+
+    for (unsigned char r : this->registers) {
+        sum += ldexp(1.0, -r);
+        zeros += r == 0;
+    }
+
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+
+    // linear counting is more accurate while many registers are still empty
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log((double)m / zeros);
+    }
+
+    return min(estimate, (double)this->count);
+}
+
+/*
+ * Upper bound on the number of occurrences of val, exact unless the sketch has collisions.
+ */
+long long columnStats::estimateFrequency(int val) const {
+    unsigned long long h = mix((unsigned long long)(unsigned int)val);
+    unsigned int est = UINT_MAX;
+
+    for (int d = 0; d < sketchDepth; d++) {
+        est = min(est, this->sketch[d * sketchWidth + (mix(h + d) & (sketchWidth - 1))]);
+    }
+
+    return est;
+}
+
+/*
+ * The most frequent values seen, with their estimated frequencies, most frequent first.
+ */
+vector<pair<int, long long>> columnStats::getHeavyHitters() const {
+    vector<pair<int, long long>> res;
+
+    for (const pair<int, long long>& hitter : this->heavyHitters) {
+        res.emplace_back(hitter.first, this->estimateFrequency(hitter.first));
+    }
+    sort(res.begin(), res.end(), [](const pair<int, long long>& a, const pair<int, long long>& b) {
+        return a.second > b.second;
+    });
+
+    return res;
+}
+
+/*
+ * Equi-depth histogram: buckets + 1 boundaries such that about count / buckets values fall between consecutive
+ * boundaries. The first and last boundaries are the exact minimum and maximum. Empty if no value was added.
+ */
+vector<int> columnStats::getHistogram(int buckets) const {
+    vector<int> bounds;
+
+    if (this->sample.empty() || buckets <= 0) {
+        return bounds;
+    }
+
+    vector<int> sorted = this->sample;
+    sort(sorted.begin(), sorted.end());
+
+    bounds.push_back(this->minVal);
+    for (int b = 1; b < buckets; b++) {
+        bounds.push_back(sorted[(long long)b * sorted.size() / buckets]);
+    }
+    bounds.push_back(this->maxVal);
+
+    return bounds;
+}
+
+/*
+ * Estimated fraction of the values lying in lo .. hi (inclusive), taken from the sample.
+ */
+double columnStats::estimateRangeFraction(int lo, int hi) const {
+    if (this->sample.empty() || lo > hi) {
+        return 0;
+    }
+
+    long long inside = 0;
+    for (int val : this->sample) {
+        inside += val >= lo && val <= hi;
+    }
+
+    return (double)inside / this->sample.size();
+}
+
+/*
+ * Private functions
+ */
+
+/*
+ * splitmix64 finalizer.
+ */
+unsigned long long columnStats::mix(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
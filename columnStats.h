@@ -0,0 +1,52 @@
+#ifndef PROJECT_COLUMNSTATS_H
+#define PROJECT_COLUMNSTATS_H
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/*
+ * Summary of the value distribution of one column, maintained incrementally with O(1) work per value:
+ *   - row count, minimum and maximum,
+ *   - a HyperLogLog sketch (4096 registers, about 1.6% standard error) for the number of distinct values,
+ *   - a Count-Min sketch for value frequencies plus a small set of heavy-hitter candidates,
+ *   - a reservoir sample from which equi-depth histograms are derived on request.
+ * All estimates are approximate; counts, minimum and maximum are exact.
+ */
+class columnStats {
+    public:
+        columnStats();
+        void add(int val);
+        long long getCount() const;
+        int getMin() const;
+        int getMax() const;
+        double estimateDistinct() const;
+        long long estimateFrequency(int val) const;
+        vector<pair<int, long long>> getHeavyHitters() const;
+        vector<int> getHistogram(int buckets) const;
+        double estimateRangeFraction(int lo, int hi) const;
+
+    private:
+        static unsigned long long mix(unsigned long long x);
+
+        /* constants */
+        static const int hllBits = 12;
+        static const int sketchDepth = 4;
+        static const int sketchWidth = 1024;
+        static const int heavyHitterCount = 16;
+        static const int sampleSize = 1024;
+
+        /* properties */
+        long long count;
+        int minVal;
+        int maxVal;
+        vector<unsigned char> registers;
+        vector<unsigned int> sketch;   // sketchDepth rows of sketchWidth counters
+        vector<pair<int, long long>> heavyHitters;   // candidate values and their estimated frequency when last seen
+        int minHitter;   // index of the candidate with the lowest frequency
+        vector<int> sample;
+        unsigned long long rngState;
+};
+
+#endif //PROJECT_COLUMNSTATS_H
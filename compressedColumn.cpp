@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include "compressedColumn.h"
+
+/*
+ * Builds the dictionary of the union of the values of cols.
+ */
+columnDictionary::columnDictionary(const vector<columnSpan>& cols) {
+    for (const columnSpan& col : cols) {
+        this->values.insert(this->values.end(), col.begin(), col.end());
+    }
+    sort(this->values.begin(), this->values.end());
+    this->values.erase(unique(this->values.begin(), this->values.end()), this->values.end());
+}
+
+/*
+ * Returns the code of val, or -1 if val is not in the dictionary.
+ */
+int columnDictionary::encode(int val) const {
+    auto it = lower_bound(this->values.begin(), this->values.end(), val);
+    return it != this->values.end() && *it == val ? it - this->values.begin() : -1;
+}
+
+int columnDictionary::size() const {
+    return this->values.size();
+}
+
+compressedColumn::compressedColumn() {
+    this->base = 0;
+    this->width = 0;
+    this->size = 0;
+}
+
+/*
+ * Encodes vals with the given dictionary, which must hold every value. Without one, the column gets its own
+ * dictionary if that takes less space than frame-of-reference encoding (few distinct values spread over a
+ * wide range), and frame-of-reference encoding otherwise.
+ */
+compressedColumn compressedColumn::encode(columnSpan vals, shared_ptr<const columnDictionary> dictionary) {
+    compressedColumn res;
+    long long minVal = INT_MAX, maxVal = INT_MIN;
+
+    for (int val : vals) {
+        minVal = min(minVal, (long long)val);
+        maxVal = max(maxVal, (long long)val);
+    }
+
+    if (!dictionary && vals.size > 0) {
+        shared_ptr<const columnDictionary> own = make_shared<const columnDictionary>(vector<columnSpan>{vals});
+        long long dictBits = (long long)vals.size * bitWidth(own->size() - 1) + 32LL * own->size();
+        long long forBits = (long long)vals.size * bitWidth(maxVal - minVal);
+
+        if (dictBits < forBits) {
+            dictionary = own;
+        }
+    }
+
+    res.dictionary = dictionary;
+    if (dictionary) {
+        res.width = bitWidth(max(0, dictionary->size() - 1));
+    } else {
+        res.base = vals.size > 0 ? minVal : 0;
+        res.width = vals.size > 0 ? bitWidth(maxVal - minVal) : 0;
+    }
+    res.words.reserve(((long long)vals.size * res.width + 63) / 64);
+
+    for (int val : vals) {
+        if (dictionary) {
+            int code = dictionary->encode(val);
+            if (code == -1) {
+                throw std::invalid_argument("Value " + to_string(val) + " is not in the dictionary!");
+            }
+            res.appendCode(code);
+        } else {
+            res.appendCode((unsigned int)((long long)val - res.base));
+        }
+    }
+
+    return res;
+}
+
+/*
+ * Returns an empty column with the same encoding, to which the codes of this column can be appended.
+ */
+compressedColumn compressedColumn::emptyLike() const {
+    compressedColumn res;
+    res.dictionary = this->dictionary;
+    res.base = this->base;
+    res.width = this->width;
+    return res;
+}
+
+unsigned int compressedColumn::getCode(int row) const {
+    if (this->width == 0) {
+        return 0;
+    }
+
+    unsigned long long bit = (unsigned long long)row * this->width;
+    int offset = bit & 63;
+    unsigned long long code = this->words[bit >> 6] >> offset;
+
+    if (offset + this->width > 64) {
+        code |= this->words[(bit >> 6) + 1] << (64 - offset);
+    }
+    return code & ((1ULL << this->width) - 1);
+}
+
+/*
+ * Unpacks the codes of rows first .. first + count - 1 into out.
+ */
+void compressedColumn::getCodes(int first, int count, unsigned int* out) const {
+    if (this->width == 0) {
+        fill(out, out + count, 0);
+        return;
+    }
+
+    unsigned long long bit = (unsigned long long)first * this->width;
+    unsigned long long mask = (1ULL << this->width) - 1;
+    for (int i = 0; i < count; i++, bit += this->width) {
+        int offset = bit & 63;
+        unsigned long long code = this->words[bit >> 6] >> offset;
+
+        if (offset + this->width > 64) {
+            code |= this->words[(bit >> 6) + 1] << (64 - offset);
+        }
+        out[i] = code & mask;
+    }
+}
+
+int compressedColumn::getValue(int row) const {
+    unsigned int code = this->getCode(row);
+    return this->dictionary ? this->dictionary->decode(code) : (int)(this->base + (long long)code);
+}
+
+/*
+ * Decodes the values of rows first .. first + count - 1 into out.
+ */
+void compressedColumn::decode(int first, int count, int* out) const {
+    for (int i = 0; i < count; i++) {
+        out[i] = this->getValue(first + i);
+    }
+}
+
+/*
+ * Appends a row holding code, which must fit the width of the column.
+ */
+void compressedColumn::appendCode(unsigned int code) {
+    if (this->width > 0) {
+        unsigned long long bit = (unsigned long long)this->size * this->width;
+        int offset = bit & 63;
+
+        while ((bit + this->width + 63) / 64 > this->words.size()) {
+            this->words.push_back(0);
+        }
+        this->words[bit >> 6] |= (unsigned long long)code << offset;
+        if (offset + this->width > 64) {
+            this->words[(bit >> 6) + 1] |= (unsigned long long)code >> (64 - offset);
+        }
+    }
+    this->size++;
+}
+
+/*
+ * Returns whether equal codes of the two columns always stand for equal values, so that the columns can be
+ * compared on their codes: both use the same dictionary, or both use the same frame of reference.
+ */
+bool compressedColumn::sharesCodes(const compressedColumn& other) const {
+    return this->dictionary == other.dictionary && (this->dictionary || this->base == other.base);
+}
+
+const shared_ptr<const columnDictionary>& compressedColumn::getDictionary() const {
+    return this->dictionary;
+}
+
+int compressedColumn::getBitWidth() const {
+    return this->width;
+}
+
+int compressedColumn::getSize() const {
+    return this->size;
+}
+
+/*
+ * Bytes of the packed codes; a dictionary is shared and not counted.
+ */
+long long compressedColumn::getSizeInBytes() const {
+    return this->words.capacity() * sizeof(unsigned long long);
+}
+
+int compressedColumn::bitWidth(unsigned long long maxCode) {
+    int width = 0;
+    while (width < 64 && (maxCode >> width) != 0) {
+        width++;
+    }
+    return width;
+}
@@ -0,0 +1,61 @@
+#ifndef PROJECT_COMPRESSEDCOLUMN_H
+#define PROJECT_COMPRESSEDCOLUMN_H
+
+#include <vector>
+#include <memory>
+#include "columnSpan.h"
+#include "memoryTracker.h"
+
+using namespace std;
+
+/*
+ * Sorted set of the distinct values of one or more columns. Code c stands for the c-th smallest value, so
+ * codes preserve the order of values. Dictionaries are immutable and shared by every column encoded with
+ * them; columns sharing a dictionary can be compared and joined on their codes.
+ */
+class columnDictionary {
+    public:
+        explicit columnDictionary(const vector<columnSpan>& cols);
+        int encode(int val) const;
+        int decode(int code) const { return this->values[code]; }
+        int size() const;
+
+    private:
+        /* properties */
+        vector<int> values;
+};
+
+/*
+ * Column of ints stored as bit-packed codes of the smallest width holding the largest code.
+ * A code is either the index of the value in a columnDictionary or, without a dictionary, the distance of the
+ * value from the column's frame of reference (its minimum). Appending codes keeps the encoding, so rows can
+ * be moved between columns of the same encoding without decoding them.
+ */
+class compressedColumn {
+    public:
+        compressedColumn();
+        static compressedColumn encode(columnSpan vals, shared_ptr<const columnDictionary> dictionary = nullptr);
+        compressedColumn emptyLike() const;
+        unsigned int getCode(int row) const;
+        void getCodes(int first, int count, unsigned int* out) const;
+        int getValue(int row) const;
+        void decode(int first, int count, int* out) const;
+        void appendCode(unsigned int code);
+        bool sharesCodes(const compressedColumn& other) const;
+        const shared_ptr<const columnDictionary>& getDictionary() const;
+        int getBitWidth() const;
+        int getSize() const;
+        long long getSizeInBytes() const;
+
+    private:
+        static int bitWidth(unsigned long long maxCode);
+
+        /* properties */
+        shared_ptr<const columnDictionary> dictionary;   // null for frame-of-reference encoding
+        int base;    // value of code 0 under frame-of-reference encoding
+        int width;   // bits per code, 0 if every code is 0
+        int size;
+        trackedVector<unsigned long long> words;
+};
+
+#endif //PROJECT_COMPRESSEDCOLUMN_H
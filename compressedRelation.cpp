@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include "compressedRelation.h"
+#include "joinHashTable.h"
+#include "queryProfile.h"
+
+// key code domains up to this size, or up to twice the rows indexed if that is more, are indexed by code
+static const long long minDirectCodes = 1 << 16;
+
+compressedRelation::compressedRelation() {
+    this->rowCount = 0;
+}
+
+/*
+ * Compresses r, choosing the encoding of every column on its own.
+ */
+compressedRelation::compressedRelation(const relation& r) : compressedRelation(r, {}) {
+}
+
+/*
+ * Compresses r, encoding the attributes found in dictionaries with the given dictionary and choosing the
+ * encoding of the others on their own.
+ */
+compressedRelation::compressedRelation(const relation& r,
+                                       const map<string, shared_ptr<const columnDictionary>>& dictionaries) {
+    this->name = r.getName();
+    this->attributes = r.getAttributes();
+    this->rowCount = r.getRowCount();
+
+    for (int c = 0; c < r.getColumnCount(); c++) {
+        auto dictionary = dictionaries.find(this->attributes[c]);
+        this->columns.push_back(compressedColumn::encode(r.getColumn(c), dictionary == dictionaries.end()
+                                                                         ? nullptr : dictionary->second));
+    }
+}
+
+/*
+ * Compresses the relations so that every attribute occurring in more than one of them is encoded with one
+ * dictionary over all its values; all joins between the results then run on codes.
+ */
+vector<compressedRelation> compressedRelation::compressShared(const vector<relation>& relations) {
+    map<string, vector<columnSpan>> occurrences;
+    for (const relation& r : relations) {
+        for (const string& attr : r.getAttributes()) {
+            occurrences[attr].push_back(r.getColumn(r.getColumnIndex(attr)));
+        }
+    }
+
+    map<string, shared_ptr<const columnDictionary>> dictionaries;
+    for (const auto& attrCols : occurrences) {
+        if (attrCols.second.size() > 1) {
+            dictionaries[attrCols.first] = make_shared<const columnDictionary>(attrCols.second);
+        }
+    }
+
+    vector<compressedRelation> res;
+    for (const relation& r : relations) {
+        res.emplace_back(r, dictionaries);
+    }
+    return res;
+}
+
+relation compressedRelation::decompress() const {
+    vector<string> attrs = this->attributes;
+    relation res(this->name, attrs);
+    res.maintainStatistics(false);
+    vector<trackedVector<int>> cols(this->getColumnCount(), trackedVector<int>(this->rowCount));
+
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        this->columns[c].decode(0, this->rowCount, cols[c].data());
+    }
+    res.appendColumns(move(cols));
+
+    return res;
+}
+
+string compressedRelation::getName() const {
+    return this->name;
+}
+
+vector<string> compressedRelation::getAttributes() const {
+    return this->attributes;
+}
+
+int compressedRelation::getColumnIndex(const string& attr) const {
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        if (this->attributes[c] == attr) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+int compressedRelation::getColumnCount() const {
+    return this->attributes.size();
+}
+
+int compressedRelation::getRowCount() const {
+    return this->rowCount;
+}
+
+const compressedColumn& compressedRelation::getColumn(int col) const {
+    if (col < 0 || col >= this->getColumnCount()) {
+        throw std::out_of_range("Column index out of range!");
+    }
+    return this->columns[col];
+}
+
+vector<int> compressedRelation::getTuple(unsigned int idx) const {
+    if (idx >= this->rowCount) {
+        throw std::out_of_range("Index out of range!");
+    }
+
+    vector<int> tup(this->getColumnCount());
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        tup[c] = this->columns[c].getValue(idx);
+    }
+    return tup;
+}
+
+/*
+ * Bytes of the packed codes of all columns; dictionaries are shared between relations and not counted.
+ */
+long long compressedRelation::getSizeInBytes() const {
+    long long bytes = 0;
+    for (const compressedColumn& col : this->columns) {
+        bytes += col.getSizeInBytes();
+    }
+    return bytes;
+}
+
+string compressedRelation::toString() const {
+    return this->decompress().toString();
+}
+
+std::ostream& operator<<(std::ostream& os, compressedRelation const& r)
+{
+    return os << r.toString();
+}
+
+/*
+ * Same result as relation::naturalJoin on the decompressed relations, without decoding: the output columns
+ * take the encoding of the input columns they come from. If both sides share the encoding of every join
+ * attribute and the keys take few enough codes, the rows of other are grouped by key code in an array
+ * indexed by code, and the probe reads the packed codes of "this" relation directly. Otherwise the join runs
+ * on a hash table whose probe keys are unpacked one batch at a time.
+ */
+compressedRelation compressedRelation::naturalJoin(const compressedRelation& other) const {
+    profileScope scope("naturalJoin");
+    scope.addInputRows(this->rowCount);
+    scope.addInputRows(other.rowCount);
+    vector<const compressedColumn*> thisKeys, otherKeys;
+    vector<bool> onCodes;
+    this->getJoinColumns(other, thisKeys, otherKeys, onCodes);
+    compressedRelation res;
+    res.name = this->name;
+
+    if (thisKeys.empty()) {
+        scope.setOutputRows(0);
+        return res;
+    }
+
+    // output column c is copied from srcCols[c], which belongs to "this" relation if fromThis[c] is set
+    vector<const compressedColumn*> srcCols;
+    vector<bool> fromThis;
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        res.attributes.push_back(this->attributes[c]);
+        srcCols.push_back(&this->columns[c]);
+        fromThis.push_back(true);
+    }
+    for (int c = 0; c < other.getColumnCount(); c++) {
+        if (this->getColumnIndex(other.attributes[c]) == -1) {
+            res.attributes.push_back(other.attributes[c]);
+            srcCols.push_back(&other.columns[c]);
+            fromThis.push_back(false);
+        }
+    }
+    for (const compressedColumn* col : srcCols) {
+        res.columns.push_back(col->emptyLike());
+    }
+
+    // appends the join of row of "this" relation with the rows of other in [first, last)
+    auto emit = [&](int row, const int* first, const int* last) {
+        for (const int* idx = first; idx != last; idx++) {
+            for (int c = 0; c < srcCols.size(); c++) {
+                res.columns[c].appendCode(srcCols[c]->getCode(fromThis[c] ? row : *idx));
+            }
+        }
+        res.rowCount += last - first;
+    };
+
+    vector<unsigned long long> sizes = getCodeCounts(otherKeys);
+    long long domain = -1;
+    if (find(onCodes.begin(), onCodes.end(), false) == onCodes.end()) {
+        domain = getCodeDomain(sizes, max(minDirectCodes, 2LL * other.rowCount));
+    }
+
+    if (domain != -1) {
+        // the rows of other with key code g are rowIds[offsets[g] .. offsets[g + 1])
+        trackedVector<int> offsets(domain + 2, 0), rowIds(other.rowCount);
+        long long codes[joinHashTable::batchSize];
+        for (int start = 0; start < other.rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, other.rowCount - start);
+            getKeyCodes(otherKeys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                offsets[codes[b] + 2]++;
+            }
+        }
+        for (long long g = 2; g < domain + 2; g++) {
+            offsets[g] += offsets[g - 1];
+        }
+        for (int start = 0; start < other.rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, other.rowCount - start);
+            getKeyCodes(otherKeys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                rowIds[offsets[codes[b] + 1]++] = start + b;
+            }
+        }
+
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            getKeyCodes(thisKeys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                if (codes[b] != -1) {
+                    emit(start + b, rowIds.data() + offsets[codes[b]], rowIds.data() + offsets[codes[b] + 1]);
+                }
+            }
+        }
+        scope.setBuild(other.rowCount);
+    } else {
+        vector<trackedVector<int>> buildKeys, probeKeys;
+        joinHashTable table(readKeys(otherKeys, onCodes, 0, other.rowCount, buildKeys));
+        int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+        for (int b = 0; b < joinHashTable::batchSize; b++) {
+            rows[b] = b;
+        }
+
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            table.findGroups(readKeys(thisKeys, onCodes, start, n, probeKeys), rows, n, groups);
+
+            for (int b = 0; b < n; b++) {
+                if (groups[b] != -1) {
+                    joinHashTable::rowRange group = table.getGroup(groups[b]);
+                    emit(start + b, group.begin(), group.end());
+                }
+            }
+        }
+        scope.setBuild(other.rowCount);
+    }
+
+    scope.setProbes(this->rowCount, res.rowCount);
+    scope.setOutputRows(res.rowCount);
+    return res;
+}
+
+/*
+ * Same result as relation::semiJoin on the decompressed relations. Like naturalJoin, keys encoded alike on both
+ * sides are looked up by code, here in a bitmap over the key codes of other, and other keys in a hash table.
+ */
+compressedRelation compressedRelation::semiJoin(const compressedRelation& other) const {
+    profileScope scope("semiJoin");
+    scope.addInputRows(this->rowCount);
+    scope.addInputRows(other.rowCount);
+    vector<const compressedColumn*> thisKeys, otherKeys;
+    vector<bool> onCodes;
+    this->getJoinColumns(other, thisKeys, otherKeys, onCodes);
+    trackedVector<int> selection;
+
+    if (thisKeys.empty()) {
+        compressedRelation res = other.rowCount > 0 ? *this : this->selectRows(selection);
+        scope.setOutputRows(res.rowCount);
+        return res;
+    }
+
+    vector<unsigned long long> sizes = getCodeCounts(otherKeys);
+    long long domain = -1;
+    if (find(onCodes.begin(), onCodes.end(), false) == onCodes.end()) {
+        // a bit per code instead of the 32 of an offset: the bitmap may cover 32 times as many codes
+        domain = getCodeDomain(sizes, 32 * max(minDirectCodes, 2LL * other.rowCount));
+    }
+
+    if (domain != -1) {
+        trackedVector<unsigned long long> present((domain + 63) / 64, 0);
+        long long codes[joinHashTable::batchSize];
+        for (int start = 0; start < other.rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, other.rowCount - start);
+            getKeyCodes(otherKeys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                present[codes[b] >> 6] |= 1ULL << (codes[b] & 63);
+            }
+        }
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            getKeyCodes(thisKeys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                if (codes[b] != -1 && ((present[codes[b] >> 6] >> (codes[b] & 63)) & 1)) {
+                    selection.push_back(start + b);
+                }
+            }
+        }
+        scope.setBuild(other.rowCount);
+    } else {
+        vector<trackedVector<int>> buildKeys, probeKeys;
+        joinHashTable keys(readKeys(otherKeys, onCodes, 0, other.rowCount, buildKeys), false);
+        int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+        for (int b = 0; b < joinHashTable::batchSize; b++) {
+            rows[b] = b;
+        }
+
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            keys.findGroups(readKeys(thisKeys, onCodes, start, n, probeKeys), rows, n, groups);
+
+            for (int b = 0; b < n; b++) {
+                if (groups[b] != -1) {
+                    selection.push_back(start + b);
+                }
+            }
+        }
+        scope.setBuild(other.rowCount);
+    }
+
+    compressedRelation res = this->selectRows(selection);
+    scope.setProbes(this->rowCount, selection.size());
+    scope.setOutputRows(res.rowCount);
+    return res;
+}
+
+/*
+ * Same result as relation::project on the decompressed relation: duplicate-free, in order of first occurrence.
+ * Duplicates are detected on codes, which identify values within a column, in a bitmap over the key codes
+ * when they are few enough and in a hash table otherwise.
+ */
+compressedRelation compressedRelation::project(vector<string>& attrs) const {
+    profileScope scope("project");
+    scope.addInputRows(this->rowCount);
+    compressedRelation res;
+    res.name = this->name;
+    vector<const compressedColumn*> keys;
+
+    for (const string& attr : attrs) {
+        int col = this->getColumnIndex(attr);
+        if (col != -1 && res.getColumnIndex(attr) == -1) {
+            keys.push_back(&this->columns[col]);
+            res.attributes.push_back(attr);
+            res.columns.push_back(this->columns[col].emptyLike());
+        }
+    }
+    if (keys.empty()) {
+        scope.setOutputRows(0);
+        return res;
+    }
+
+    // appends row of "this" relation to the result
+    auto keep = [&](int row) {
+        for (int k = 0; k < keys.size(); k++) {
+            res.columns[k].appendCode(keys[k]->getCode(row));
+        }
+        res.rowCount++;
+    };
+
+    vector<unsigned long long> sizes = getCodeCounts(keys);
+    long long domain = getCodeDomain(sizes, 32 * max(minDirectCodes, 2LL * this->rowCount));
+
+    if (domain != -1) {
+        trackedVector<unsigned long long> seen((domain + 63) / 64, 0);
+        long long codes[joinHashTable::batchSize];
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            getKeyCodes(keys, sizes, start, n, codes);
+            for (int b = 0; b < n; b++) {
+                if (((seen[codes[b] >> 6] >> (codes[b] & 63)) & 1) == 0) {
+                    seen[codes[b] >> 6] |= 1ULL << (codes[b] & 63);
+                    keep(start + b);
+                }
+            }
+        }
+    } else {
+        // the first row of every group of equal codes is kept
+        vector<trackedVector<int>> codes;
+        vector<columnSpan> keyCols = readKeys(keys, vector<bool>(keys.size(), true), 0, this->rowCount, codes);
+        joinHashTable groupTable(keyCols, false);
+        vector<bool> seen(groupTable.getKeyCount(), false);
+        int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+
+        for (int start = 0; start < this->rowCount; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, this->rowCount - start);
+            for (int b = 0; b < n; b++) {
+                rows[b] = start + b;
+            }
+            groupTable.findGroups(keyCols, rows, n, groups);
+
+            for (int b = 0; b < n; b++) {
+                if (!seen[groups[b]]) {
+                    seen[groups[b]] = true;
+                    keep(rows[b]);
+                }
+            }
+        }
+    }
+
+    scope.setOutputRows(res.rowCount);
+    return res;
+}
+
+/*
+ * Private functions
+ */
+
+/*
+ * Collects the columns of the attributes shared by "this" relation and other, in the column order of "this"
+ * relation: thisCols[i] and otherCols[i] hold the same attribute, and onCodes[i] tells whether they share
+ * their encoding, so that keys can be compared on codes.
+ */
+void compressedRelation::getJoinColumns(const compressedRelation& other, vector<const compressedColumn*>& thisCols,
+                                        vector<const compressedColumn*>& otherCols, vector<bool>& onCodes) const {
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        int otherCol = other.getColumnIndex(this->attributes[c]);
+        if (otherCol != -1) {
+            thisCols.push_back(&this->columns[c]);
+            otherCols.push_back(&other.columns[otherCol]);
+            onCodes.push_back(this->columns[c].sharesCodes(other.columns[otherCol]));
+        }
+    }
+}
+
+/*
+ * Number of codes every column may hold: its dictionary size, or all codes of its bit width.
+ */
+vector<unsigned long long> compressedRelation::getCodeCounts(const vector<const compressedColumn*>& cols) {
+    vector<unsigned long long> sizes;
+    for (const compressedColumn* col : cols) {
+        const shared_ptr<const columnDictionary>& dictionary = col->getDictionary();
+        sizes.push_back(max(1ULL, dictionary ? dictionary->size() : 1ULL << col->getBitWidth()));
+    }
+    return sizes;
+}
+
+/*
+ * Number of combined key codes of columns holding sizes[k] codes each, or -1 if it exceeds limit.
+ */
+long long compressedRelation::getCodeDomain(const vector<unsigned long long>& sizes, long long limit) {
+    long long domain = 1;
+    for (unsigned long long size : sizes) {
+        if (size > (unsigned long long)limit || domain > limit / (long long)size) {
+            return -1;
+        }
+        domain *= size;
+    }
+    return domain;
+}
+
+/*
+ * Writes the combined key codes of rows first .. first + count - 1 (at most joinHashTable::batchSize) to out:
+ * the codes of cols in the mixed radix sizes, or -1 where a code exceeds its size (the key then does not occur
+ * in the columns the sizes were taken from).
+ */
+void compressedRelation::getKeyCodes(const vector<const compressedColumn*>& cols,
+                                     const vector<unsigned long long>& sizes, int first, int count, long long* out) {
+    unsigned int codes[joinHashTable::batchSize];
+    long long stride = 1;
+
+    fill(out, out + count, 0);
+    for (int k = 0; k < cols.size(); k++) {
+        cols[k]->getCodes(first, count, codes);
+        for (int i = 0; i < count; i++) {
+            out[i] = out[i] == -1 || codes[i] >= sizes[k] ? -1 : out[i] + codes[i] * stride;
+        }
+        stride *= sizes[k];
+    }
+}
+
+/*
+ * Unpacks rows first .. first + count - 1 of the key columns cols into keys, one array per column holding
+ * codes where onCodes is set and values otherwise, and returns spans over them.
+ */
+vector<columnSpan> compressedRelation::readKeys(const vector<const compressedColumn*>& cols,
+                                                const vector<bool>& onCodes, int first, int count,
+                                                vector<trackedVector<int>>& keys) {
+    vector<columnSpan> spans;
+    keys.resize(cols.size());
+
+    for (int k = 0; k < cols.size(); k++) {
+        keys[k].resize(count);
+        if (onCodes[k]) {
+            cols[k]->getCodes(first, count, (unsigned int*)keys[k].data());
+        } else {
+            cols[k]->decode(first, count, keys[k].data());
+        }
+        spans.push_back(columnSpan{keys[k].data(), count});
+    }
+    return spans;
+}
+
+/*
+ * Returns the given rows of "this" relation, in the given order, keeping the encoding of every column.
+ */
+compressedRelation compressedRelation::selectRows(const trackedVector<int>& rows) const {
+    compressedRelation res;
+    res.name = this->name;
+    res.attributes = this->attributes;
+    res.rowCount = rows.size();
+
+    for (const compressedColumn& col : this->columns) {
+        res.columns.push_back(col.emptyLike());
+        for (int row : rows) {
+            res.columns.back().appendCode(col.getCode(row));
+        }
+    }
+
+    return res;
+}
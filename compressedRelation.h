@@ -0,0 +1,63 @@
+#ifndef PROJECT_COMPRESSEDRELATION_H
+#define PROJECT_COMPRESSEDRELATION_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include "compressedColumn.h"
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Read-only relation whose columns are stored as bit-packed codes (see compressedColumn), typically a few
+ * bits per value instead of 32 for join columns with a few thousand distinct values.
+ * Joins, semi-joins and projections produce compressed results without decoding: output rows copy the codes
+ * of their input rows, and key columns are matched on their codes wherever both sides share the encoding.
+ * Keys with few enough distinct codes are looked up in arrays or bitmaps indexed by code, read straight from
+ * the packed columns, so the working set of a probe stays compressed.
+ * compressShared gives every attribute one dictionary across a set of relations so that this holds for all
+ * of their joins. Values are only decoded by getTuple, toString and decompress. Operator results keep the
+ * name of "this" relation.
+ */
+class compressedRelation {
+    public:
+        compressedRelation();
+        explicit compressedRelation(const relation& r);
+        compressedRelation(const relation& r, const map<string, shared_ptr<const columnDictionary>>& dictionaries);
+        static vector<compressedRelation> compressShared(const vector<relation>& relations);
+        relation decompress() const;
+        string getName() const;
+        vector<string> getAttributes() const;
+        int getColumnIndex(const string& attr) const;
+        int getColumnCount() const;
+        int getRowCount() const;
+        const compressedColumn& getColumn(int col) const;
+        vector<int> getTuple(unsigned int idx) const;
+        long long getSizeInBytes() const;
+        string toString() const;
+        friend std::ostream& operator<<(std::ostream& os, compressedRelation const& r);
+        compressedRelation naturalJoin(const compressedRelation& other) const;
+        compressedRelation semiJoin(const compressedRelation& other) const;
+        compressedRelation project(vector<string>& attrs) const;
+
+    private:
+        void getJoinColumns(const compressedRelation& other, vector<const compressedColumn*>& thisCols,
+                            vector<const compressedColumn*>& otherCols, vector<bool>& onCodes) const;
+        compressedRelation selectRows(const trackedVector<int>& rows) const;
+
+        static vector<unsigned long long> getCodeCounts(const vector<const compressedColumn*>& cols);
+        static long long getCodeDomain(const vector<unsigned long long>& sizes, long long limit);
+        static void getKeyCodes(const vector<const compressedColumn*>& cols, const vector<unsigned long long>& sizes,
+                                int first, int count, long long* out);
+        static vector<columnSpan> readKeys(const vector<const compressedColumn*>& cols, const vector<bool>& onCodes,
+                                           int first, int count, vector<trackedVector<int>>& keys);
+
+        /* properties */
+        string name;
+        vector<string> attributes;   // in column order
+        vector<compressedColumn> columns;
+        int rowCount;
+};
+
+#endif //PROJECT_COMPRESSEDRELATION_H
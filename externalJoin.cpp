@@ -0,0 +1,419 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+#include "externalJoin.h"
+#include "joinHashTable.h"
+#include "queryProfile.h"
+
+// estimated bytes of a joinHashTable per build row, on top of the row's own columns
+static const long long tableBytesPerRow = 48;
+
+/*
+ * memoryBudget bounds the bytes held by the in-memory hash tables plus the partition buffers. tempDir defaults
+ * to $TMPDIR, or /tmp; fanout is rounded up to a power of two.
+ */
+externalJoin::externalJoin(long long memoryBudget, const string& tempDir, int fanout) {
+    if (memoryBudget <= 0) {
+        throw std::invalid_argument("Memory budget must be positive!");
+    }
+
+    this->budget = memoryBudget;
+    this->tempDir = tempDir;
+    if (this->tempDir.empty()) {
+        const char* env = getenv("TMPDIR");
+        this->tempDir = env != nullptr && *env != '\0' ? env : "/tmp";
+    }
+    this->bitsPerLevel = 1;
+    while ((1 << this->bitsPerLevel) < fanout && this->bitsPerLevel < 8) {
+        this->bitsPerLevel++;
+    }
+    this->fanout = 1 << this->bitsPerLevel;
+    this->blockRows = 0;
+    this->spilledBytes = 0;
+    this->partitionCount = 0;
+    this->maxDepth = 0;
+    this->sink = nullptr;
+    this->resultRows = 0;
+}
+
+/*
+ * Joins left and right like left.naturalJoin(right), passing every result tuple (in the attribute order of
+ * getAttributes) to sink, and returns the number of result tuples. Like naturalJoin, inputs without a shared
+ * attribute give an empty result.
+ */
+long long externalJoin::run(const relation& left, const relation& right, const tupleSink& sink) {
+    profileScope scope("externalJoin");
+    scope.addInput(left);
+    scope.addInput(right);
+    joinSide leftSide, rightSide;
+    leftSide.rel = &left;
+    rightSide.rel = &right;
+
+    this->outCols.clear();
+    this->fromLeft.clear();
+    for (const string& attr : getAttributes(left, right)) {
+        int leftCol = left.getColumnIndex(attr);
+        this->fromLeft.push_back(leftCol != -1);
+        this->outCols.push_back(leftCol != -1 ? leftCol : right.getColumnIndex(attr));
+    }
+    for (const string& attr : left.getAttributes()) {
+        if (right.getColumnIndex(attr) != -1) {
+            leftSide.keyCols.push_back(left.getColumnIndex(attr));
+            rightSide.keyCols.push_back(right.getColumnIndex(attr));
+        }
+    }
+
+    this->sink = &sink;
+    this->resultRows = 0;
+    this->spilledBytes = 0;
+    this->partitionCount = 0;
+    this->maxDepth = 0;
+    if (leftSide.keyCols.empty()) {
+        return 0;
+    }
+
+    leftSide.rows = left.getRowCount();
+    leftSide.colCount = left.getColumnCount();
+    rightSide.rows = right.getRowCount();
+    rightSide.colCount = right.getColumnCount();
+
+    // all partition buffers of one input together take at most half the budget
+    long long bufferBytes = (long long)this->fanout * max(leftSide.colCount, rightSide.colCount) * sizeof(int);
+    this->blockRows = max(64LL, min(1LL << 16, this->budget / 2 / bufferBytes));
+
+    this->join(leftSide, rightSide, 0);
+
+    scope.setProbes(leftSide.rows + rightSide.rows, this->resultRows);
+    return this->resultRows;
+}
+
+/*
+ * Same as run(left, right, sink), writing the result to outputPath as delimited text with one tuple per line
+ * (readable by relationLoader).
+ */
+long long externalJoin::run(const relation& left, const relation& right, const string& outputPath, char delimiter) {
+    ofstream out(outputPath);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + outputPath + "!");
+    }
+
+    string line;
+    long long rows = this->run(left, right, [&](const vector<int>& tuple) {
+        line.clear();
+        for (int c = 0; c < tuple.size(); c++) {
+            if (c > 0) {
+                line.push_back(delimiter);
+            }
+            line += to_string(tuple[c]);
+        }
+        line.push_back('\n');
+        out << line;
+    });
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Cannot write " + outputPath + "!");
+    }
+    return rows;
+}
+
+/*
+ * Attributes of the result: those of left, then those of right not in left.
+ */
+vector<string> externalJoin::getAttributes(const relation& left, const relation& right) {
+    vector<string> attrs = left.getAttributes();
+    for (const string& attr : right.getAttributes()) {
+        if (left.getColumnIndex(attr) == -1) {
+            attrs.push_back(attr);
+        }
+    }
+    return attrs;
+}
+
+/*
+ * Bytes written to temporary files by the last run.
+ */
+long long externalJoin::getSpilledBytes() const {
+    return this->spilledBytes;
+}
+
+/*
+ * Number of temporary partition files written by the last run.
+ */
+int externalJoin::getPartitionCount() const {
+    return this->partitionCount;
+}
+
+/*
+ * Deepest level of partitioning of the last run; 0 if it ran entirely in memory.
+ */
+int externalJoin::getMaxDepth() const {
+    return this->maxDepth;
+}
+
+/*
+ * Private functions
+ */
+
+externalJoin::spillFile::~spillFile() {
+    remove(this->path.c_str());
+}
+
+void externalJoin::join(const joinSide& left, const joinSide& right, int depth) {
+    if (left.rows == 0 || right.rows == 0) {
+        return;
+    }
+
+    bool buildIsLeft = left.rows < right.rows;
+    const joinSide& build = buildIsLeft ? left : right;
+    const joinSide& probe = buildIsLeft ? right : left;
+
+    // every level consumes bitsPerLevel bits of the 32-bit key hash
+    if (this->fits(build) || (depth + 1) * this->bitsPerLevel > 32) {
+        this->joinChunked(build, probe, buildIsLeft);
+        return;
+    }
+
+    this->maxDepth = max(this->maxDepth, depth + 1);
+    vector<joinSide> leftParts = this->partition(left, depth);
+    vector<joinSide> rightParts = this->partition(right, depth);
+
+    for (int p = 0; p < this->fanout; p++) {
+        // a partition holding all rows of both sides will not split any further: its rows share one key
+        if (leftParts[p].rows == left.rows && rightParts[p].rows == right.rows) {
+            bool partBuildIsLeft = leftParts[p].rows < rightParts[p].rows;
+            this->joinChunked(partBuildIsLeft ? leftParts[p] : rightParts[p],
+                              partBuildIsLeft ? rightParts[p] : leftParts[p], partBuildIsLeft);
+        } else {
+            this->join(leftParts[p], rightParts[p], depth + 1);
+        }
+        leftParts[p].file.reset();
+        rightParts[p].file.reset();
+    }
+}
+
+/*
+ * Loads the build side one chunk of as many rows as fit the budget at a time and probes every chunk with the
+ * whole probe side.
+ */
+void externalJoin::joinChunked(const joinSide& build, const joinSide& probe, bool buildIsLeft) {
+    long long rowBytes = build.colCount * sizeof(int) + tableBytesPerRow;
+    int chunkCapacity = max(1LL, min((long long)build.rows, this->budget / rowBytes));
+    vector<trackedVector<int>> chunk(build.colCount);
+    int chunkRows = 0;
+
+    for (trackedVector<int>& col : chunk) {
+        col.reserve(chunkCapacity);
+    }
+
+    this->scan(build, [&](const block& b) {
+        for (int r = 0; r < b.rows; r++) {
+            for (int c = 0; c < build.colCount; c++) {
+                chunk[c].push_back(b.cols[c][r]);
+            }
+            if (++chunkRows == chunkCapacity) {
+                this->probeChunk(chunk, chunkRows, build, probe, buildIsLeft);
+                for (trackedVector<int>& col : chunk) {
+                    col.clear();
+                }
+                chunkRows = 0;
+            }
+        }
+    });
+
+    if (chunkRows > 0) {
+        this->probeChunk(chunk, chunkRows, build, probe, buildIsLeft);
+    }
+}
+
+void externalJoin::probeChunk(const vector<trackedVector<int>>& chunk, int chunkRows, const joinSide& build,
+                              const joinSide& probe, bool buildIsLeft) {
+    vector<columnSpan> buildKeys;
+    for (int col : build.keyCols) {
+        buildKeys.push_back(columnSpan{chunk[col].data(), chunkRows});
+    }
+
+    joinHashTable table(buildKeys);
+    vector<int> tuple(this->outCols.size());
+    int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+
+    this->scan(probe, [&](const block& b) {
+        vector<columnSpan> probeKeys;
+        for (int col : probe.keyCols) {
+            probeKeys.push_back(b.cols[col]);
+        }
+
+        for (int start = 0; start < b.rows; start += joinHashTable::batchSize) {
+            int n = min(joinHashTable::batchSize, b.rows - start);
+            for (int i = 0; i < n; i++) {
+                rows[i] = start + i;
+            }
+            table.findGroups(probeKeys, rows, n, groups);
+
+            for (int i = 0; i < n; i++) {
+                if (groups[i] == -1) {
+                    continue;
+                }
+                for (int idx : table.getGroup(groups[i])) {
+                    for (int c = 0; c < this->outCols.size(); c++) {
+                        bool fromBuild = this->fromLeft[c] == buildIsLeft;
+                        tuple[c] = fromBuild ? chunk[this->outCols[c]][idx] : b.cols[this->outCols[c]][rows[i]];
+                    }
+                    (*this->sink)(tuple);
+                    this->resultRows++;
+                }
+            }
+        }
+    });
+}
+
+/*
+ * Splits side into fanout temporary files by bits [32 - (depth + 1) * bitsPerLevel, 32 - depth * bitsPerLevel)
+ * of the hash of its key. Rows are buffered per partition and written blockRows at a time.
+ */
+vector<externalJoin::joinSide> externalJoin::partition(const joinSide& side, int depth) {
+    vector<joinSide> parts(this->fanout);
+    vector<FILE*> outs(this->fanout, nullptr);
+    vector<vector<trackedVector<int>>> buffers(this->fanout, vector<trackedVector<int>>(side.colCount));
+    int shift = 32 - (depth + 1) * this->bitsPerLevel;
+
+    for (joinSide& part : parts) {
+        part.colCount = side.colCount;
+        part.keyCols = side.keyCols;
+    }
+
+    auto flush = [&](int p) {
+        unsigned int rows = buffers[p][0].size();
+        if (rows == 0) {
+            return;
+        }
+        if (outs[p] == nullptr) {
+            parts[p].file = this->createFile(outs[p]);
+            this->partitionCount++;
+        }
+
+        bool ok = fwrite(&rows, sizeof(rows), 1, outs[p]) == 1;
+        for (trackedVector<int>& col : buffers[p]) {
+            ok = ok && fwrite(col.data(), sizeof(int), rows, outs[p]) == rows;
+            col.clear();
+        }
+        if (!ok) {
+            throw std::runtime_error("Cannot write spill file " + parts[p].file->path + "!");
+        }
+        parts[p].rows += rows;
+        this->spilledBytes += sizeof(rows) + (long long)rows * side.colCount * sizeof(int);
+    };
+
+    try {
+        this->scan(side, [&](const block& b) {
+            vector<columnSpan> keys;
+            for (int col : side.keyCols) {
+                keys.push_back(b.cols[col]);
+            }
+
+            for (int r = 0; r < b.rows; r++) {
+                int p = (joinHashTable::hashRow(keys, r) >> shift) & (this->fanout - 1);
+
+                for (int c = 0; c < side.colCount; c++) {
+                    buffers[p][c].push_back(b.cols[c][r]);
+                }
+                if (buffers[p][0].size() == this->blockRows) {
+                    flush(p);
+                }
+            }
+        });
+
+        for (int p = 0; p < this->fanout; p++) {
+            flush(p);
+        }
+    } catch (...) {
+        for (FILE* out : outs) {
+            if (out != nullptr) {
+                fclose(out);
+            }
+        }
+        throw;
+    }
+
+    for (int p = 0; p < this->fanout; p++) {
+        if (outs[p] != nullptr && fclose(outs[p]) != 0) {
+            throw std::runtime_error("Cannot write spill file " + parts[p].file->path + "!");
+        }
+    }
+    return parts;
+}
+
+/*
+ * Passes the rows of side to fn in blocks of at most blockRows rows.
+ */
+void externalJoin::scan(const joinSide& side, const blockSink& fn) const {
+    block b;
+
+    if (side.rel != nullptr) {
+        vector<columnSpan> cols;
+        for (int c = 0; c < side.colCount; c++) {
+            cols.push_back(side.rel->getColumn(c));
+        }
+
+        for (long long start = 0; start < side.rows; start += this->blockRows) {
+            b.rows = min((long long)this->blockRows, side.rows - start);
+            b.cols.clear();
+            for (const columnSpan& col : cols) {
+                b.cols.push_back(columnSpan{col.data + start, b.rows});
+            }
+            fn(b);
+        }
+        return;
+    }
+
+    FILE* in = fopen(side.file->path.c_str(), "rb");
+    if (in == nullptr) {
+        throw std::runtime_error("Cannot read spill file " + side.file->path + "!");
+    }
+
+    vector<trackedVector<int>> cols(side.colCount, trackedVector<int>(this->blockRows));
+    unsigned int rows;
+    try {
+        while (fread(&rows, sizeof(rows), 1, in) == 1) {
+            b.rows = rows;
+            b.cols.clear();
+            for (trackedVector<int>& col : cols) {
+                if (rows > col.size() || fread(col.data(), sizeof(int), rows, in) != rows) {
+                    throw std::runtime_error("Spill file " + side.file->path + " is truncated!");
+                }
+                b.cols.push_back(columnSpan{col.data(), b.rows});
+            }
+            fn(b);
+        }
+    } catch (...) {
+        fclose(in);
+        throw;
+    }
+    fclose(in);
+}
+
+shared_ptr<externalJoin::spillFile> externalJoin::createFile(FILE*& out) const {
+    string path = this->tempDir + "/projectSpillXXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot create a spill file in " + this->tempDir + "!");
+    }
+
+    shared_ptr<spillFile> file = make_shared<spillFile>();
+    file->path = path;
+    out = fdopen(fd, "wb");
+    if (out == nullptr) {
+        close(fd);
+        throw std::runtime_error("Cannot write spill file " + path + "!");
+    }
+    return file;
+}
+
+/*
+ * Whether the hash table over all rows of side fits the budget.
+ */
+bool externalJoin::fits(const joinSide& side) const {
+    return side.rows * (side.colCount * (long long)sizeof(int) + tableBytesPerRow) <= this->budget;
+}
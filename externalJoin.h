@@ -0,0 +1,82 @@
+#ifndef PROJECT_EXTERNALJOIN_H
+#define PROJECT_EXTERNALJOIN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Grace hash join for inputs whose hash table does not fit in a memory budget.
+ * If the smaller input (the build side) fits, it is joined in memory in one pass. Otherwise both inputs are
+ * hash-partitioned on their shared attributes into "fanout" temporary files each, and every pair of matching
+ * partitions is joined the same way, so a partition that is still too large is partitioned again on the next
+ * bits of the hash. A pair that cannot be split further (one heavy key, or the hash bits are used up) is
+ * joined in chunks: the build side is loaded one budget-sized chunk at a time and the probe side is scanned
+ * once per chunk. Output tuples are streamed to a sink or a delimited text file and never materialized.
+ * Inputs may be memory-mapped relations (see relationFile), which are read sequentially.
+ * Temporary files are created in tempDir and removed as soon as their partition has been joined.
+ */
+class externalJoin {
+    public:
+        explicit externalJoin(long long memoryBudget, const string& tempDir = "", int fanout = 16);
+        long long run(const relation& left, const relation& right, const tupleSink& sink);
+        long long run(const relation& left, const relation& right, const string& outputPath, char delimiter = ',');
+        static vector<string> getAttributes(const relation& left, const relation& right);
+        long long getSpilledBytes() const;
+        int getPartitionCount() const;
+        int getMaxDepth() const;
+
+    private:
+        /* private structs */
+        // temporary file of columnar blocks: u32 row count, then the values of every column of those rows
+        struct spillFile {
+            string path;
+            ~spillFile();
+        };
+
+        // one input of a (sub)join: a relation, or a partition of one spilled to a file
+        struct joinSide {
+            const relation* rel = nullptr;
+            shared_ptr<spillFile> file;
+            long long rows = 0;
+            int colCount = 0;
+            vector<int> keyCols;
+        };
+
+        // columns of up to blockRows consecutive rows of a joinSide
+        struct block {
+            vector<columnSpan> cols;
+            int rows;
+        };
+
+        typedef function<void(const block&)> blockSink;
+
+        void join(const joinSide& left, const joinSide& right, int depth);
+        void joinChunked(const joinSide& build, const joinSide& probe, bool buildIsLeft);
+        void probeChunk(const vector<trackedVector<int>>& chunk, int chunkRows, const joinSide& build,
+                        const joinSide& probe, bool buildIsLeft);
+        vector<joinSide> partition(const joinSide& side, int depth);
+        void scan(const joinSide& side, const blockSink& fn) const;
+        shared_ptr<spillFile> createFile(FILE*& out) const;
+        bool fits(const joinSide& side) const;
+
+        /* properties */
+        long long budget;
+        string tempDir;
+        int fanout;
+        int bitsPerLevel;
+        int blockRows;
+        long long spilledBytes;
+        int partitionCount;
+        int maxDepth;
+        // state of the running join: output column c is column outCols[c] of the left input if fromLeft[c] is set
+        vector<int> outCols;
+        vector<bool> fromLeft;
+        const tupleSink* sink;
+        long long resultRows;
+};
+
+#endif //PROJECT_EXTERNALJOIN_H
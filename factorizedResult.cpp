@@ -0,0 +1,216 @@
+#include <stdexcept>
+#include <unordered_set>
+#include "factorizedResult.h"
+
+factorizedResult::factorizedResult() {
+    this->count = 0;
+}
+
+/*
+ * Reduces relations with the two semi-join sweeps of the Yannakakis algorithm, indexes every relation on the
+ * attributes it shares with its predecessor and computes, from the tail to the head, how many result suffixes
+ * start at every row. All of this takes O(N) time and space; no result tuple is formed.
+ */
+factorizedResult::factorizedResult(const vector<relation>& relations) {
+    int k = relations.size();
+    this->count = 0;
+
+    if (k == 0) {
+        return;
+    }
+
+    this->attributes = relation::getLineJoinAttributes(relations);
+    this->reduced = relation::reduceLine(relations);
+    this->tables.resize(k);
+    this->probeCols.resize(k);
+    this->newCols.resize(k);
+    this->newPos.resize(k);
+    this->weightPrefix.resize(k);
+    unordered_set<string> bound;
+
+    for (int i = 0; i < k; i++) {
+        const relation& r = this->reduced[i];
+
+        for (const string& attr : r.getAttributes()) {
+            if (bound.insert(attr).second) {
+                this->newCols[i].push_back(r.getColumn(r.getColumnIndex(attr)));
+                this->newPos[i].push_back(find(this->attributes.begin(), this->attributes.end(), attr) - this->attributes.begin());
+            }
+        }
+
+        if (i > 0) {
+            vector<columnSpan> buildCols;
+            this->reduced[i-1].getSharedColumns(r, this->probeCols[i], buildCols);
+
+            // consecutive relations without a shared attribute do not join (as in naturalJoin)
+            if (buildCols.empty()) {
+                return;
+            }
+            this->tables[i] = joinHashTable(buildCols);
+        }
+    }
+
+    vector<long long> weights(this->reduced[k-1].getRowCount(), 1);
+
+    for (int i = k-1; i >= 1; i--) {
+        const trackedVector<int>& payload = this->tables[i].getRowIds();
+        vector<long long>& prefix = this->weightPrefix[i];
+        prefix.assign(payload.size() + 1, 0);
+
+        for (int p = 0; p < payload.size(); p++) {
+            prefix[p + 1] = prefix[p] + weights[payload[p]];
+        }
+
+        vector<long long> prevWeights(this->reduced[i-1].getRowCount(), 0);
+        for (int r = 0; r < prevWeights.size(); r++) {
+            joinHashTable::rowRange range = this->tables[i].probe(this->probeCols[i], r);
+
+            if (!range.empty()) {
+                prevWeights[r] = prefix[range.end() - payload.data()] - prefix[range.begin() - payload.data()];
+            }
+        }
+        weights = move(prevWeights);
+    }
+
+    vector<long long>& firstPrefix = this->weightPrefix[0];
+    firstPrefix.assign(weights.size() + 1, 0);
+    for (int r = 0; r < weights.size(); r++) {
+        firstPrefix[r + 1] = firstPrefix[r] + weights[r];
+    }
+
+    this->count = firstPrefix.back();
+}
+
+long long factorizedResult::getCount() const {
+    return this->count;
+}
+
+vector<string> factorizedResult::getAttributes() const {
+    return this->attributes;
+}
+
+/*
+ * Returns the result tuple of the given rank (0 based, in enumeration order) by descending the chain and
+ * binary searching the suffix counts at every level.
+ */
+vector<int> factorizedResult::getTuple(long long rank) const {
+    if (rank < 0 || rank >= this->count) {
+        throw std::out_of_range("Rank out of range!");
+    }
+
+    int k = this->reduced.size();
+    vector<int> tuple(this->attributes.size());
+    const vector<long long>& firstPrefix = this->weightPrefix[0];
+    int row = upper_bound(firstPrefix.begin(), firstPrefix.end(), rank) - firstPrefix.begin() - 1;
+    rank -= firstPrefix[row];
+
+    for (int level = 0; ; level++) {
+        for (int c = 0; c < this->newCols[level].size(); c++) {
+            tuple[this->newPos[level][c]] = this->newCols[level][c][row];
+        }
+
+        if (level == k-1) {
+            return tuple;
+        }
+
+        const joinHashTable& table = this->tables[level + 1];
+        const vector<long long>& prefix = this->weightPrefix[level + 1];
+        joinHashTable::rowRange range = table.probe(this->probeCols[level + 1], row);
+        int first = range.begin() - table.getRowIds().data();
+        int last = range.end() - table.getRowIds().data();
+        long long target = prefix[first] + rank;
+        int pos = upper_bound(prefix.begin() + first, prefix.begin() + last + 1, target) - prefix.begin() - 1;
+
+        rank = target - prefix[pos];
+        row = table.getRowIds()[pos];
+    }
+}
+
+factorizedResult::enumerator factorizedResult::enumerate() const {
+    return enumerator(*this);
+}
+
+/*
+ * Flattens the result into a relation. This costs O(OUT) memory and is only meant for small results.
+ */
+relation factorizedResult::toRelation() const {
+    vector<string> attrs = this->attributes;
+    relation res(attrs);
+    res.maintainStatistics(false);
+    res.reserve(this->count);
+    enumerator e = this->enumerate();
+
+    while (e.next()) {
+        vector<int> tuple = e.getTuple();
+        res.insertTuple(tuple);
+    }
+
+    return res;
+}
+
+/*
+ * Enumerator
+ */
+
+factorizedResult::enumerator::enumerator(const factorizedResult& res) {
+    this->res = &res;
+    this->cursors.resize(res.reduced.size());
+    this->tuple.resize(res.attributes.size());
+    this->nextFirstRow = 0;
+    this->level = 0;
+}
+
+/*
+ * Advances to the next result tuple and returns false once all tuples have been produced. Since the relations
+ * are fully reduced, every probe yields at least one row and the work between two tuples is O(k).
+ */
+bool factorizedResult::enumerator::next() {
+    int k = this->res->reduced.size();
+
+    if (this->res->count == 0) {
+        return false;
+    }
+
+    while (true) {
+        if (this->level == 0) {
+            if (this->nextFirstRow >= this->res->reduced[0].getRowCount()) {
+                return false;
+            }
+
+            int row = this->nextFirstRow++;
+            this->bind(0, row);
+
+            if (k == 1) {
+                return true;
+            }
+            this->level = 1;
+            this->cursors[1] = this->res->tables[1].probe(this->res->probeCols[1], row);
+            continue;
+        }
+
+        joinHashTable::rowRange& cursor = this->cursors[this->level];
+        if (cursor.empty()) {
+            this->level--;
+            continue;
+        }
+
+        int row = *cursor.first++;
+        this->bind(this->level, row);
+
+        if (this->level == k-1) {
+            return true;
+        }
+        this->level++;
+        this->cursors[this->level] = this->res->tables[this->level].probe(this->res->probeCols[this->level], row);
+    }
+}
+
+const vector<int>& factorizedResult::enumerator::getTuple() const {
+    return this->tuple;
+}
+
+void factorizedResult::enumerator::bind(int level, int row) {
+    for (int c = 0; c < this->res->newCols[level].size(); c++) {
+        this->tuple[this->res->newPos[level][c]] = this->res->newCols[level][c][row];
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef PROJECT_FACTORIZEDRESULT_H
+#define PROJECT_FACTORIZEDRESULT_H
+
+#include <string>
+#include <vector>
+#include "relation.h"
+#include "joinHashTable.h"
+
+using namespace std;
+
+/*
+ * Result of a line join query q(A1, ... , Ak+1) :- R1(A1, A2), ..., Rk(Ak, Ak+1) kept in factorized form:
+ * the fully reduced relations plus one hash index per relation on the attributes it shares with its
+ * predecessor. Every result tuple is a path R1 -> R2 -> ... -> Rk through those indexes, so the result takes
+ * space proportional to the input while supporting
+ *   - exact counting in O(1),
+ *   - enumeration with constant delay between consecutive tuples (see enumerator),
+ *   - random access to the tuple of a given rank in O(k log N).
+ * Tuples are ordered as getAttributes(), and ranks follow the enumeration order.
+ * The indexes point into the reduced relations held by the object, so it can be moved but not copied.
+ */
+class factorizedResult {
+    public:
+        /*
+         * Depth-first walk over all result tuples.
+         */
+        class enumerator {
+            public:
+                explicit enumerator(const factorizedResult& res);
+                bool next();
+                const vector<int>& getTuple() const;
+
+            private:
+                void bind(int level, int row);
+
+                const factorizedResult* res;
+                vector<joinHashTable::rowRange> cursors;
+                vector<int> tuple;
+                int nextFirstRow;
+                int level;
+        };
+
+        factorizedResult();
+        explicit factorizedResult(const vector<relation>& relations);
+        factorizedResult(factorizedResult&& other) = default;
+        factorizedResult& operator=(factorizedResult&& other) = default;
+        factorizedResult(const factorizedResult& other) = delete;
+        factorizedResult& operator=(const factorizedResult& other) = delete;
+
+        long long getCount() const;
+        vector<string> getAttributes() const;
+        vector<int> getTuple(long long rank) const;
+        enumerator enumerate() const;
+        relation toRelation() const;
+
+    private:
+        /* properties */
+        vector<string> attributes;
+        vector<relation> reduced;
+        // relation i is reached by probing tables[i] with the columns probeCols[i] of relation i-1
+        // and binds its columns newCols[i] to the output positions newPos[i]
+        vector<joinHashTable> tables;
+        vector<vector<columnSpan>> probeCols;
+        vector<vector<columnSpan>> newCols;
+        vector<vector<int>> newPos;
+        // weightPrefix[0][r] is the number of result tuples starting in rows 0 .. r-1 of the first relation, and for
+        // i > 0 weightPrefix[i][p] sums the suffix counts of the rows at payload positions 0 .. p-1 of tables[i]
+        vector<vector<long long>> weightPrefix;
+        long long count;
+};
+
+#endif //PROJECT_FACTORIZEDRESULT_H
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include "joinHashTable.h"
+#include "parallel.h"
+#include "simdKernels.h"
+
+joinHashTable::joinHashTable() {
+    this->mask = 0;
+    this->offsets.push_back(0);
+}
+
+joinHashTable::joinHashTable(columnSpan keys) {
+    this->keyCols.push_back(keys);
+    this->build(nullptr, keys.size, true);
+}
+
+joinHashTable::joinHashTable(const vector<columnSpan>& keys, bool storeRowIds) {
+    this->keyCols = keys;
+    this->build(nullptr, keys.empty() ? 0 : keys[0].size, storeRowIds);
+}
+
+/*
+ * Builds the table on the given subset of rows only (e.g. one radix partition). Returned row ids refer to
+ * the full key columns.
+ */
+joinHashTable::joinHashTable(const vector<columnSpan>& keys, const int* rows, int rowCount, bool storeRowIds) {
+    this->keyCols = keys;
+    this->build(rows, rowCount, storeRowIds);
+}
+
+/*
+ * Returns the ids of all rows whose key equals key. The range is empty if the key does not occur.
+ * Only valid for tables built on a single key column.
+ */
+joinHashTable::rowRange joinHashTable::probe(int key) const {
+    return this->groupRows(this->findSlot(key));
+}
+
+/*
+ * Returns the ids of all rows whose key equals the key of row "row" in probeKeys. probeKeys must hold
+ * as many columns as the table was built on, in the same order.
+ */
+joinHashTable::rowRange joinHashTable::probe(const vector<columnSpan>& probeKeys, int row) const {
+    return this->groupRows(this->findSlot(probeKeys, row));
+}
+
+bool joinHashTable::contains(int key) const {
+    return this->findSlot(key) != -1;
+}
+
+bool joinHashTable::contains(const vector<columnSpan>& probeKeys, int row) const {
+    return this->findSlot(probeKeys, row) != -1;
+}
+
+/*
+ * Returns the group (dense index in [0, getKeyCount())) of the key of row "row" in probeKeys, or -1 if the
+ * key does not occur. Groups let callers keep per-key state in a plain vector.
+ */
+int joinHashTable::findGroup(const vector<columnSpan>& probeKeys, int row) const {
+    int pos = this->findSlot(probeKeys, row);
+    return pos == -1 ? -1 : this->slots[pos].group;
+}
+
+/*
+ * Batched findGroup: groups[i] = findGroup(probeKeys, rows[i]). The keys of a batch are hashed with vector
+ * instructions and all their slots are prefetched before the first one is inspected, so the cache misses of
+ * a batch overlap instead of being paid one after another. Composite keys are compared column by column over
+ * the whole batch; the rare probe whose hash matched a different key falls back to findGroup.
+ */
+void joinHashTable::findGroups(const vector<columnSpan>& probeKeys, const int* rows, int count, int* groups) const {
+    if (this->slots.empty()) {
+        fill(groups, groups + count, -1);
+        return;
+    }
+
+    bool composite = probeKeys.size() > 1;
+    int keys[batchSize], candidates[batchSize], candidateRows[batchSize], firsts[batchSize];
+    unsigned int hashes[batchSize];
+    unsigned char equal[batchSize];
+
+    for (int start = 0; start < count; start += batchSize) {
+        int n = min(batchSize, count - start);
+        const int* batchRows = rows + start;
+        int* batchGroups = groups + start;
+
+        // single column tables store the key itself, composite ones the hash of the key
+        if (composite) {
+            simdKernels::hashRows(probeKeys, batchRows, n, keys);
+        } else {
+            simdKernels::gather(probeKeys[0], batchRows, n, keys);
+        }
+        simdKernels::hashKeys(keys, n, hashes);
+
+        for (int i = 0; i < n; i++) {
+            __builtin_prefetch(&this->slots[hashes[i] & this->mask]);
+        }
+
+        int candidateCount = 0;
+        for (int i = 0; i < n; i++) {
+            unsigned int pos = hashes[i] & this->mask;
+            batchGroups[i] = -1;
+
+            while (this->slots[pos].group != -1) {
+                if (this->slots[pos].key == keys[i]) {
+                    batchGroups[i] = this->slots[pos].group;
+                    break;
+                }
+                pos = (pos + 1) & this->mask;
+            }
+
+            if (composite && batchGroups[i] != -1) {
+                candidates[candidateCount] = i;
+                firsts[candidateCount] = this->firstRows[batchGroups[i]];
+                candidateRows[candidateCount] = batchRows[i];
+                equal[candidateCount] = 1;
+                candidateCount++;
+            }
+        }
+
+        for (int c = 0; c < (int)probeKeys.size() && candidateCount > 0; c++) {
+            simdKernels::matchKeys(probeKeys[c], candidateRows, this->keyCols[c], firsts, candidateCount, equal);
+        }
+        for (int j = 0; j < candidateCount; j++) {
+            if (!equal[j]) {
+                batchGroups[candidates[j]] = this->findGroup(probeKeys, batchRows[candidates[j]]);
+            }
+        }
+    }
+}
+
+joinHashTable::rowRange joinHashTable::getGroup(int group) const {
+    const int* base = this->rowIds.data();
+    return rowRange{base + this->offsets[group], base + this->offsets[group + 1]};
+}
+
+int joinHashTable::getKeyCount() const {
+    return this->offsets.size() - 1;
+}
+
+int joinHashTable::getRowCount() const {
+    return this->rowIds.size();
+}
+
+/*
+ * Bytes held by the table's own arrays (the key columns it spans are not counted).
+ */
+long long joinHashTable::getMemoryUsage() const {
+    return this->slots.capacity() * sizeof(slot) + (this->firstRows.capacity() + this->offsets.capacity()
+           + this->rowIds.capacity()) * sizeof(int);
+}
+
+/*
+ * The payload array: row ids grouped by key. Ranges returned by probe() point into it.
+ */
+const trackedVector<int>& joinHashTable::getRowIds() const {
+    return this->rowIds;
+}
+
+/*
+ * Fibonacci hashing: the high bits of the product are well mixed even for sequential keys.
+ */
+unsigned int joinHashTable::hashKey(int key) {
+    unsigned long long h = (unsigned long long)(unsigned int)key * 0x9E3779B97F4A7C15ULL;
+    return (unsigned int)(h >> 32);
+}
+
+unsigned int joinHashTable::hashRow(const vector<columnSpan>& keys, int row) {
+    unsigned int h = 0;
+
+    for (const columnSpan& col : keys) {
+        h = hashKey(col[row] ^ (int)(h * 0x85EBCA6BU));
+    }
+
+    return h;
+}
+
+/*
+ * Radix partitioning: groups the row ids of the key columns by the top "bits" bits of their key hash.
+ * Rows of partition p are returned at positions offsets[p] .. offsets[p+1], keeping their relative order.
+ * Every thread histograms and then scatters one contiguous chunk of rows, so no synchronization is needed
+ * beyond the prefix sum between the two phases.
+ */
+vector<int> joinHashTable::partitionRows(const vector<columnSpan>& keys, int bits, unsigned int threadCount, vector<int>& offsets) {
+    int rowCount = keys[0].size;
+    int partitionCount = 1 << bits;
+    int chunkCount = max(1, (int)min<unsigned int>(threadCount, (rowCount + 4095) / 4096));
+    int chunkSize = (rowCount + chunkCount - 1) / chunkCount;
+    vector<int> partitionIds(rowCount);
+    vector<vector<int>> histograms(chunkCount, vector<int>(partitionCount, 0));
+
+    parallelFor(chunkCount, threadCount, [&](int chunk, int) {
+        int end = min(rowCount, (chunk + 1) * chunkSize);
+        vector<int>& histogram = histograms[chunk];
+
+        for (int i = chunk * chunkSize; i < end; i++) {
+            int p = bits == 0 ? 0 : (int)(hashRow(keys, i) >> (32 - bits));
+            partitionIds[i] = p;
+            histogram[p]++;
+        }
+    });
+
+    // turn the histograms into the write cursor of every (chunk, partition) pair
+    offsets.assign(partitionCount + 1, 0);
+    int pos = 0;
+    for (int p = 0; p < partitionCount; p++) {
+        offsets[p] = pos;
+        for (int chunk = 0; chunk < chunkCount; chunk++) {
+            int count = histograms[chunk][p];
+            histograms[chunk][p] = pos;
+            pos += count;
+        }
+    }
+    offsets[partitionCount] = pos;
+
+    vector<int> rows(rowCount);
+    parallelFor(chunkCount, threadCount, [&](int chunk, int) {
+        int end = min(rowCount, (chunk + 1) * chunkSize);
+        vector<int>& cursor = histograms[chunk];
+
+        for (int i = chunk * chunkSize; i < end; i++) {
+            rows[cursor[partitionIds[i]]++] = i;
+        }
+    });
+
+    return rows;
+}
+
+/*
+ * Private functions
+ */
+
+/*
+ * Builds the table in two passes over the key columns. The first pass assigns every distinct key a group
+ * and counts its rows, the prefix sum of the counts gives each group its offset in the payload array, and
+ * the second pass scatters the row ids into place. Key sets (storeRowIds unset) stop after the first pass.
+ * If rows is not null only rows[0 .. rowCount) are inserted.
+ */
+void joinHashTable::build(const int* rows, int rowCount, bool storeRowIds) {
+    bool composite = this->keyCols.size() > 1;
+    unsigned int capacity = 16;
+
+    // keep the load factor at or below one half so that probe sequences stay short
+    while (capacity < 2 * (unsigned int)rowCount) {
+        capacity <<= 1;
+    }
+    this->slots.assign(capacity, slot{0, -1});
+    this->mask = capacity - 1;
+
+    trackedVector<int> rowGroups(storeRowIds ? rowCount : 0);
+    trackedVector<int> counts;
+
+    for (int i = 0; i < rowCount; i++) {
+        int row = rows == nullptr ? i : rows[i];
+        int pos = composite ? this->findSlot(this->keyCols, row) : this->findSlot(this->keyCols[0][row]);
+
+        if (pos == -1) {
+            int key = composite ? (int)hashRow(this->keyCols, row) : this->keyCols[0][row];
+            unsigned int free = hashKey(key) & this->mask;
+
+            while (this->slots[free].group != -1) {
+                free = (free + 1) & this->mask;
+            }
+
+            this->slots[free] = slot{key, (int)counts.size()};
+            this->firstRows.push_back(row);
+            counts.push_back(0);
+            pos = free;
+        }
+
+        if (storeRowIds) {
+            rowGroups[i] = this->slots[pos].group;
+            counts[rowGroups[i]]++;
+        }
+    }
+
+    int groupCount = counts.size();
+    this->offsets.assign(groupCount + 1, 0);
+    if (!storeRowIds) {
+        return;
+    }
+
+    for (int g = 0; g < groupCount; g++) {
+        this->offsets[g + 1] = this->offsets[g] + counts[g];
+    }
+
+    // counts is reused as the write cursor of every group
+    for (int g = 0; g < groupCount; g++) {
+        counts[g] = this->offsets[g];
+    }
+    this->rowIds.resize(rowCount);
+    for (int i = 0; i < rowCount; i++) {
+        this->rowIds[counts[rowGroups[i]]++] = rows == nullptr ? i : rows[i];
+    }
+}
+
+/*
+ * Returns the slot holding key or -1 if the key is not in the table.
+ */
+int joinHashTable::findSlot(int key) const {
+    if (this->slots.empty()) {
+        return -1;
+    }
+
+    unsigned int pos = hashKey(key) & this->mask;
+
+    while (this->slots[pos].group != -1) {
+        if (this->slots[pos].key == key) {
+            return pos;
+        }
+        pos = (pos + 1) & this->mask;
+    }
+
+    return -1;
+}
+
+int joinHashTable::findSlot(const vector<columnSpan>& probeKeys, int row) const {
+    if (probeKeys.size() == 1) {
+        return this->findSlot(probeKeys[0][row]);
+    }
+    if (this->slots.empty()) {
+        return -1;
+    }
+
+    int h = hashRow(probeKeys, row);
+    unsigned int pos = hashKey(h) & this->mask;
+    int colCount = probeKeys.size();
+
+    while (this->slots[pos].group != -1) {
+        if (this->slots[pos].key == h) {
+            int first = this->firstRows[this->slots[pos].group];
+            int c = 0;
+
+            while (c < colCount && this->keyCols[c][first] == probeKeys[c][row]) {
+                c++;
+            }
+            if (c == colCount) {
+                return pos;
+            }
+        }
+        pos = (pos + 1) & this->mask;
+    }
+
+    return -1;
+}
+
+joinHashTable::rowRange joinHashTable::groupRows(int pos) const {
+    if (pos == -1) {
+        return rowRange{nullptr, nullptr};
+    }
+
+    return this->getGroup(this->slots[pos].group);
+}
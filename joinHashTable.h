@@ -0,0 +1,78 @@
+#ifndef PROJECT_JOINHASHTABLE_H
+#define PROJECT_JOINHASHTABLE_H
+
+#include <vector>
+#include "columnSpan.h"
+#include "memoryTracker.h"
+
+using namespace std;
+
+/*
+ * Hash table mapping join key values onto the ids of the rows holding them.
+ * Keys live in an open-addressing (linear probing) slot array and the row ids of all keys are
+ * stored back to back in one payload array, so a build performs a fixed number of allocations
+ * and a probe touches one slot plus one contiguous run of row ids.
+ * The key may span several columns; a probe then compares every key column, so all returned rows
+ * are true matches. The table keeps spans of the build-side key columns and must not outlive them.
+ * A table built without row ids is a plain key set: only contains(), findGroup(s) and getKeyCount() may be used.
+ */
+class joinHashTable {
+    public:
+        /*
+         * Contiguous run of row ids sharing one key, in ascending row order.
+         */
+        struct rowRange {
+            const int* first;
+            const int* last;
+
+            const int* begin() const { return first; }
+            const int* end() const { return last; }
+            bool empty() const { return first == last; }
+            int size() const { return last - first; }
+        };
+
+        joinHashTable();
+        explicit joinHashTable(columnSpan keys);
+        explicit joinHashTable(const vector<columnSpan>& keys, bool storeRowIds = true);
+        joinHashTable(const vector<columnSpan>& keys, const int* rows, int rowCount, bool storeRowIds = true);
+        rowRange probe(int key) const;
+        rowRange probe(const vector<columnSpan>& probeKeys, int row) const;
+        bool contains(int key) const;
+        bool contains(const vector<columnSpan>& probeKeys, int row) const;
+        int findGroup(const vector<columnSpan>& probeKeys, int row) const;
+        void findGroups(const vector<columnSpan>& probeKeys, const int* rows, int count, int* groups) const;
+        rowRange getGroup(int group) const;
+        int getKeyCount() const;
+        int getRowCount() const;
+        const trackedVector<int>& getRowIds() const;
+        long long getMemoryUsage() const;
+
+        // number of probes findGroups resolves together; a good batch size for its callers
+        static constexpr int batchSize = 256;
+
+        static unsigned int hashKey(int key);
+        static unsigned int hashRow(const vector<columnSpan>& keys, int row);
+        static vector<int> partitionRows(const vector<columnSpan>& keys, int bits, unsigned int threadCount, vector<int>& offsets);
+
+    private:
+        void build(const int* rows, int rowCount, bool storeRowIds);
+        int findSlot(int key) const;
+        int findSlot(const vector<columnSpan>& probeKeys, int row) const;
+        rowRange groupRows(int pos) const;
+
+        /* private structs */
+        struct slot {
+            int key;     // the key itself for single column keys, otherwise the hash of the key
+            int group;   // index into offsets, -1 marks an empty slot
+        };
+
+        /* properties */
+        vector<columnSpan> keyCols;
+        trackedVector<slot> slots;
+        unsigned int mask;
+        trackedVector<int> firstRows;   // first row of every group, used to compare composite keys
+        trackedVector<int> offsets;     // rows of group g are rowIds[offsets[g] .. offsets[g+1])
+        trackedVector<int> rowIds;
+};
+
+#endif //PROJECT_JOINHASHTABLE_H
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include "joinPlanner.h"
+
+joinPlanner::joinPlanner() = default;
+
+joinPlanner::joinPlanner(const vector<relation>& relations) {
+    int k = relations.size();
+    this->cardinalities.assign(k, vector<double>(k, 0));
+    this->costs.assign(k, vector<double>(k, 0));
+    this->splits.assign(k, vector<int>(k, -1));
+
+    // selectivities[i] is the estimated fraction of pairs of Ri x Ri+1 that join
+    vector<double> selectivities(k, 1);
+    for (int i = 0; i + 1 < k; i++) {
+        double pairs = (double)relations[i].getRowCount() * relations[i+1].getRowCount();
+        selectivities[i] = pairs == 0 ? 0 : relations[i].estimateJoinSize(relations[i+1]) / pairs;
+    }
+
+    for (int i = 0; i < k; i++) {
+        this->names.push_back(relations[i].getName().empty() ? "R" + to_string(i + 1) : relations[i].getName());
+        this->cardinalities[i][i] = relations[i].getRowCount();
+    }
+
+    for (int len = 2; len <= k; len++) {
+        for (int first = 0; first + len <= k; first++) {
+            int last = first + len - 1;
+            double card = this->cardinalities[first][last - 1] * relations[last].getRowCount() * selectivities[last - 1];
+            this->cardinalities[first][last] = card;
+            this->costs[first][last] = -1;
+
+            for (int split = first; split < last; split++) {
+                double cost = this->costs[first][split] + this->costs[split + 1][last] + card;
+
+                if (this->costs[first][last] < 0 || cost < this->costs[first][last]) {
+                    this->costs[first][last] = cost;
+                    this->splits[first][last] = split;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Estimated cost (sum of intermediate and final join sizes) of the chosen plan.
+ */
+double joinPlanner::getCost() const {
+    return this->costs.empty() ? 0 : this->costs[0].back();
+}
+
+double joinPlanner::getCardinality(int first, int last) const {
+    return this->cardinalities.at(first).at(last);
+}
+
+/*
+ * The chosen plan joins first .. split with split+1 .. last. Returns -1 if first == last.
+ */
+int joinPlanner::getSplit(int first, int last) const {
+    return this->splits.at(first).at(last);
+}
+
+/*
+ * Prints the chosen plan, e.g. ((R1 JOIN R2) JOIN (R3 JOIN R4)), followed by its estimated cost.
+ */
+string joinPlanner::toString() const {
+    if (this->names.empty()) {
+        return "(empty)";
+    }
+    return this->planToString(0, this->names.size() - 1) + " [estimated cost " + to_string((long long)this->getCost()) + "]";
+}
+
+/*
+ * Evaluates the chosen plan on relations, which must be the relations the plan was built for.
+ */
+relation joinPlanner::execute(const vector<relation>& relations) const {
+    if (relations.size() != this->names.size()) {
+        throw std::invalid_argument("Plan was built for a different query!");
+    }
+    if (relations.empty()) {
+        return relation();
+    }
+    return this->executePlan(relations, 0, relations.size() - 1);
+}
+
+/*
+ * Private functions
+ */
+
+string joinPlanner::planToString(int first, int last) const {
+    if (first == last) {
+        return this->names[first];
+    }
+
+    int split = this->splits[first][last];
+    return "(" + this->planToString(first, split) + " JOIN " + this->planToString(split + 1, last) + ")";
+}
+
+relation joinPlanner::executePlan(const vector<relation>& relations, int first, int last) const {
+    if (first == last) {
+        return relations[first];
+    }
+
+    int split = this->splits[first][last];
+    return this->executePlan(relations, first, split).naturalJoin(this->executePlan(relations, split + 1, last));
+}
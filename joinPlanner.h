@@ -0,0 +1,41 @@
+#ifndef PROJECT_JOINPLANNER_H
+#define PROJECT_JOINPLANNER_H
+
+#include <string>
+#include <vector>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Cost-based join order optimizer for line join queries q(A1, ... , Ak+1) :- R1(A1, A2), ..., Rk(Ak, Ak+1).
+ * On a line the only connected sub-queries are intervals Ri .. Rj, so dynamic programming over intervals
+ * enumerates every cross-product free plan, bushy ones included, in O(k^3). The size of an interval's join is
+ * estimated from the column statistics of neighbouring relations (relation::estimateJoinSize, which corrects
+ * |R join S| = |R| |S| / max(V(R,a), V(S,a)) for heavy hitters), and the cost of a plan is the sum of the
+ * estimated sizes of all the joins it performs. The cheapest plan can be inspected and executed.
+ */
+class joinPlanner {
+    public:
+        joinPlanner();
+        explicit joinPlanner(const vector<relation>& relations);
+        double getCost() const;
+        double getCardinality(int first, int last) const;
+        int getSplit(int first, int last) const;
+        string toString() const;
+        relation execute(const vector<relation>& relations) const;
+
+    private:
+        string planToString(int first, int last) const;
+        relation executePlan(const vector<relation>& relations, int first, int last) const;
+
+        /* properties */
+        vector<string> names;
+        // for the interval first .. last: estimated join size, cost of the cheapest plan and the position
+        // after which that plan splits the interval into two sub-plans (-1 for single relations)
+        vector<vector<double>> cardinalities;
+        vector<vector<double>> costs;
+        vector<vector<int>> splits;
+};
+
+#endif //PROJECT_JOINPLANNER_H
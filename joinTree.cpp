@@ -0,0 +1,140 @@
+#include <set>
+#include <unordered_map>
+#include "joinTree.h"
+
+joinTree::joinTree(const vector<relation>& relations) {
+    int n = relations.size();
+    vector<set<string>> edges(n);
+    vector<bool> alive(n, true);
+    int aliveCount = n;
+
+    this->parents.assign(n, -1);
+    this->children.resize(n);
+    this->root = -1;
+    this->connected = true;
+
+    for (int i = 0; i < n; i++) {
+        vector<string> attrs = relations[i].getAttributes();
+        edges[i].insert(attrs.begin(), attrs.end());
+        this->names.push_back(relations[i].getName().empty() ? "R" + to_string(i + 1) : relations[i].getName());
+    }
+
+    bool changed = true;
+    while (changed && aliveCount > 1) {
+        changed = false;
+
+        // remove attributes occurring in a single remaining relation
+        unordered_map<string, int> occurrences;
+        for (int i = 0; i < n; i++) {
+            if (alive[i]) {
+                for (const string& attr : edges[i]) {
+                    occurrences[attr]++;
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (!alive[i]) {
+                continue;
+            }
+            for (auto it = edges[i].begin(); it != edges[i].end(); ) {
+                if (occurrences[*it] == 1) {
+                    it = edges[i].erase(it);
+                    changed = true;
+                } else {
+                    it++;
+                }
+            }
+        }
+
+        // remove relations contained in another relation, which becomes their parent
+        for (int i = 0; i < n && aliveCount > 1; i++) {
+            if (!alive[i]) {
+                continue;
+            }
+            for (int j = 0; j < n; j++) {
+                if (j != i && alive[j] && includes(edges[j].begin(), edges[j].end(), edges[i].begin(), edges[i].end())) {
+                    // an emptied relation shares nothing with the rest of the query
+                    if (edges[i].empty()) {
+                        this->connected = false;
+                    }
+                    this->parents[i] = j;
+                    this->children[j].push_back(i);
+                    alive[i] = false;
+                    aliveCount--;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    this->acyclic = aliveCount <= 1;
+    for (int i = 0; i < n; i++) {
+        if (alive[i] && this->acyclic) {
+            this->root = i;
+        }
+    }
+}
+
+bool joinTree::isAcyclic() const {
+    return this->acyclic;
+}
+
+bool joinTree::isConnected() const {
+    return this->connected;
+}
+
+int joinTree::getRoot() const {
+    return this->root;
+}
+
+int joinTree::getParent(int node) const {
+    return this->parents[node];
+}
+
+const vector<int>& joinTree::getChildren(int node) const {
+    return this->children[node];
+}
+
+/*
+ * Returns the nodes with every child before its parent, ending with the root. Empty if the query is cyclic.
+ */
+vector<int> joinTree::postOrder() const {
+    vector<int> order;
+
+    if (this->root != -1) {
+        this->appendPostOrder(this->root, order);
+    }
+
+    return order;
+}
+
+string joinTree::toString() const {
+    string res;
+
+    if (this->root == -1) {
+        return "(cyclic)\n";
+    }
+    this->appendToString(this->root, 0, res);
+
+    return res;
+}
+
+/*
+ * Private functions
+ */
+
+void joinTree::appendPostOrder(int node, vector<int>& order) const {
+    for (int child : this->children[node]) {
+        this->appendPostOrder(child, order);
+    }
+    order.push_back(node);
+}
+
+void joinTree::appendToString(int node, int depth, string& res) const {
+    res += string(2 * depth, ' ') + this->names[node] + '\n';
+
+    for (int child : this->children[node]) {
+        this->appendToString(child, depth + 1, res);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PROJECT_JOINTREE_H
+#define PROJECT_JOINTREE_H
+
+#include <string>
+#include <vector>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Join tree of a natural join query over a set of relations, found with the GYO reduction: attributes that
+ * occur in a single relation are removed, and a relation whose remaining attributes are contained in those of
+ * another becomes that relation's child. The query is (alpha-)acyclic iff this reduces it to a single
+ * relation, which becomes the root. Nodes are indexes into the relations passed to the constructor.
+ */
+class joinTree {
+    public:
+        explicit joinTree(const vector<relation>& relations);
+        bool isAcyclic() const;
+        bool isConnected() const;
+        int getRoot() const;
+        int getParent(int node) const;
+        const vector<int>& getChildren(int node) const;
+        vector<int> postOrder() const;
+        string toString() const;
+
+    private:
+        void appendPostOrder(int node, vector<int>& order) const;
+        void appendToString(int node, int depth, string& res) const;
+
+        /* properties */
+        vector<string> names;
+        vector<int> parents;
+        vector<vector<int>> children;
+        int root;
+        bool acyclic;
+        bool connected;
+};
+
+#endif //PROJECT_JOINTREE_H
@@ -0,0 +1,203 @@
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include "leapfrogTriejoin.h"
+
+/*
+ * Uses the attributes in order of first appearance over relations as variable order.
+ */
+leapfrogTriejoin::leapfrogTriejoin(const vector<relation>& relations) {
+    this->variables = relation::getLineJoinAttributes(relations);
+    this->build(relations);
+}
+
+/*
+ * variableOrder must list every attribute of relations exactly once. A good order binds the most selective
+ * variables first.
+ */
+leapfrogTriejoin::leapfrogTriejoin(const vector<relation>& relations, const vector<string>& variableOrder) {
+    vector<string> attrs = relation::getLineJoinAttributes(relations);
+    vector<string> sortedOrder = variableOrder;
+    sort(attrs.begin(), attrs.end());
+    sort(sortedOrder.begin(), sortedOrder.end());
+
+    if (attrs != sortedOrder) {
+        throw std::invalid_argument("Variable order must list every attribute exactly once!");
+    }
+
+    this->variables = variableOrder;
+    this->build(relations);
+}
+
+vector<string> leapfrogTriejoin::getAttributes() const {
+    return this->variables;
+}
+
+/*
+ * Hands every result tuple (ordered as getAttributes()) to sink and returns their number.
+ */
+long long leapfrogTriejoin::run(const tupleSink& sink) const {
+    int trieCount = this->tries.size();
+    vector<int> lo(trieCount, 0), hi(trieCount);
+    vector<int> tuple(this->variables.size());
+
+    for (int t = 0; t < trieCount; t++) {
+        hi[t] = this->tries[t].levels.empty() ? 0 : this->tries[t].levels[0].size();
+    }
+
+    if (trieCount == 0) {
+        return 0;
+    }
+
+    return this->join(0, lo, hi, tuple, sink);
+}
+
+relation leapfrogTriejoin::execute() const {
+    vector<string> attrs = this->variables;
+    relation res(attrs);
+    res.maintainStatistics(false);
+
+    this->run([&res](const vector<int>& tuple) {
+        vector<int> tup = tuple;
+        res.insertTuple(tup);
+    });
+
+    return res;
+}
+
+/*
+ * Private functions
+ */
+
+void leapfrogTriejoin::build(const vector<relation>& relations) {
+    unordered_map<string, int> varIdx;
+    for (int v = 0; v < this->variables.size(); v++) {
+        varIdx[this->variables[v]] = v;
+    }
+
+    this->participants.resize(this->variables.size());
+
+    for (int t = 0; t < relations.size(); t++) {
+        const relation& r = relations[t];
+        vector<string> attrs = r.getAttributes();
+        sort(attrs.begin(), attrs.end(), [&varIdx](const string& a, const string& b) {
+            return varIdx[a] < varIdx[b];
+        });
+
+        vector<columnSpan> cols;
+        for (int d = 0; d < attrs.size(); d++) {
+            cols.push_back(r.getColumn(r.getColumnIndex(attrs[d])));
+            this->participants[varIdx[attrs[d]]].push_back(participant{t, d});
+        }
+
+        trackedVector<int> order(r.getRowCount());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&cols](int a, int b) {
+            for (const columnSpan& col : cols) {
+                if (col[a] != col[b]) {
+                    return col[a] < col[b];
+                }
+            }
+            return false;
+        });
+
+        trie tr;
+        tr.levels.resize(cols.size());
+        for (int d = 0; d < cols.size(); d++) {
+            tr.levels[d].resize(order.size());
+            for (int i = 0; i < order.size(); i++) {
+                tr.levels[d][i] = cols[d][order[i]];
+            }
+        }
+        this->tries.push_back(move(tr));
+    }
+}
+
+/*
+ * Binds variable var. lo[t] .. hi[t] is the range of trie t matching the variables bound so far; the ranges
+ * of the participants of var are narrowed for the recursive call and restored afterwards.
+ */
+long long leapfrogTriejoin::join(int var, vector<int>& lo, vector<int>& hi, vector<int>& tuple, const tupleSink& sink) const {
+    if (var == this->variables.size()) {
+        sink(tuple);
+        return 1;
+    }
+
+    const vector<participant>& parts = this->participants[var];
+    int partCount = parts.size();
+    vector<int> pos(partCount), oldLo(partCount), oldHi(partCount);
+    long long count = 0;
+
+    for (int p = 0; p < partCount; p++) {
+        int t = parts[p].trieIdx;
+        if (lo[t] >= hi[t]) {
+            return 0;
+        }
+        pos[p] = lo[t];
+        oldLo[p] = lo[t];
+        oldHi[p] = hi[t];
+    }
+
+    bool exhausted = false;
+
+    while (!exhausted) {
+        // leapfrog: move every iterator to the largest current value until they all agree
+        int maxVal = this->tries[parts[0].trieIdx].levels[parts[0].level][pos[0]];
+        for (int p = 1; p < partCount; p++) {
+            maxVal = max(maxVal, this->tries[parts[p].trieIdx].levels[parts[p].level][pos[p]]);
+        }
+
+        bool agreed = true;
+        for (int p = 0; p < partCount && !exhausted; p++) {
+            const trackedVector<int>& col = this->tries[parts[p].trieIdx].levels[parts[p].level];
+            pos[p] = seek(col, pos[p], oldHi[p], maxVal);
+            exhausted = pos[p] == oldHi[p];
+            agreed = agreed && !exhausted && col[pos[p]] == maxVal;
+        }
+
+        if (!agreed) {
+            continue;
+        }
+
+        // every participant is positioned at maxVal: narrow their ranges to it and bind the next variable
+        for (int p = 0; p < partCount; p++) {
+            int t = parts[p].trieIdx;
+            const trackedVector<int>& col = this->tries[t].levels[parts[p].level];
+            lo[t] = pos[p];
+            hi[t] = upper_bound(col.begin() + pos[p], col.begin() + oldHi[p], maxVal) - col.begin();
+        }
+
+        tuple[var] = maxVal;
+        count += this->join(var + 1, lo, hi, tuple, sink);
+
+        for (int p = 0; p < partCount; p++) {
+            int t = parts[p].trieIdx;
+            pos[p] = hi[t];
+            lo[t] = oldLo[p];
+            hi[t] = oldHi[p];
+            exhausted = exhausted || pos[p] == oldHi[p];
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Galloping search: returns the first position in pos .. end whose value is at least val, probing
+ * exponentially growing steps before binary searching the last one.
+ */
+int leapfrogTriejoin::seek(const trackedVector<int>& col, int pos, int end, int val) {
+    if (pos >= end || col[pos] >= val) {
+        return pos;
+    }
+
+    int step = 1;
+    int prev = pos;
+    while (pos + step < end && col[pos + step] < val) {
+        prev = pos + step;
+        step <<= 1;
+    }
+
+    int last = min(end, pos + step + 1);
+    return lower_bound(col.begin() + prev + 1, col.begin() + last, val) - col.begin();
+}
@@ -0,0 +1,52 @@
+#ifndef PROJECT_LEAPFROGTRIEJOIN_H
+#define PROJECT_LEAPFROGTRIEJOIN_H
+
+#include <string>
+#include <vector>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Worst-case optimal multiway natural join (Leapfrog Triejoin, Veldhuizen 2014). Every relation is sorted
+ * lexicographically on its attributes in a global variable order, which makes it a trie with one level per
+ * attribute. The join then binds one variable at a time: the candidate values of a variable are the
+ * intersection of the matching trie levels of all relations holding it, found by leapfrogging between sorted
+ * ranges with galloping search. Its running time is bounded by the AGM bound of the query (up to a log
+ * factor), e.g. O(N^1.5) for the triangle R(A,B), S(B,C), T(C,A), where any pairwise plan may need O(N^2).
+ * Works for cyclic and acyclic queries alike. Like all set-based joins it returns every distinct binding
+ * once, so duplicate input tuples do not multiply in the output.
+ */
+class leapfrogTriejoin {
+    public:
+        explicit leapfrogTriejoin(const vector<relation>& relations);
+        leapfrogTriejoin(const vector<relation>& relations, const vector<string>& variableOrder);
+        vector<string> getAttributes() const;
+        long long run(const tupleSink& sink) const;
+        relation execute() const;
+
+    private:
+        void build(const vector<relation>& relations);
+        long long join(int var, vector<int>& lo, vector<int>& hi, vector<int>& tuple, const tupleSink& sink) const;
+
+        static int seek(const trackedVector<int>& col, int pos, int end, int val);
+
+        /* private structs */
+        // one relation sorted on its attributes in variable order; levels[d] holds the values of level d
+        struct trie {
+            vector<trackedVector<int>> levels;
+        };
+
+        // a relation holding a variable, and the trie level at which it does so
+        struct participant {
+            int trieIdx;
+            int level;
+        };
+
+        /* properties */
+        vector<string> variables;
+        vector<trie> tries;
+        vector<vector<participant>> participants;   // participants[v] lists the relations holding variable v
+};
+
+#endif //PROJECT_LEAPFROGTRIEJOIN_H
@@ -0,0 +1,177 @@
+#include <climits>
+#include <stdexcept>
+#include "lineJoinAggregate.h"
+#include "joinHashTable.h"
+
+lineJoinAggregate::lineJoinAggregate(const vector<relation>& relations) {
+    int k = relations.size();
+    this->relations = relations;
+    this->left.resize(k);
+    this->right.resize(k);
+
+    for (int i = 0; i < k; i++) {
+        this->left[i].assign(relations[i].getRowCount(), 0);
+        this->right[i].assign(relations[i].getRowCount(), 0);
+    }
+
+    if (k == 0) {
+        return;
+    }
+
+    this->left[0].assign(relations[0].getRowCount(), 1);
+    this->right[k-1].assign(relations[k-1].getRowCount(), 1);
+
+    // head to tail: left[i][r] sums left[i-1] over the rows of Ri-1 joining row r
+    for (int i = 1; i < k; i++) {
+        vector<columnSpan> thisKeyCols, prevKeyCols;
+        relations[i].getSharedColumns(relations[i-1], thisKeyCols, prevKeyCols);
+
+        // consecutive relations without a shared attribute do not join (as in naturalJoin)
+        if (thisKeyCols.empty()) {
+            for (int j = 0; j < k; j++) {
+                this->right[j].assign(relations[j].getRowCount(), 0);
+            }
+            return;
+        }
+
+        joinHashTable table(prevKeyCols);
+        vector<long long> groupSums(table.getKeyCount(), 0);
+        for (int g = 0; g < groupSums.size(); g++) {
+            for (int row : table.getGroup(g)) {
+                groupSums[g] += this->left[i-1][row];
+            }
+        }
+
+        for (int r = 0; r < relations[i].getRowCount(); r++) {
+            int g = table.findGroup(thisKeyCols, r);
+            this->left[i][r] = g == -1 ? 0 : groupSums[g];
+        }
+    }
+
+    // tail to head: right[i][r] sums right[i+1] over the rows of Ri+1 joining row r
+    for (int i = k-2; i >= 0; i--) {
+        vector<columnSpan> thisKeyCols, nextKeyCols;
+        relations[i].getSharedColumns(relations[i+1], thisKeyCols, nextKeyCols);
+
+        joinHashTable table(nextKeyCols);
+        vector<long long> groupSums(table.getKeyCount(), 0);
+        for (int g = 0; g < groupSums.size(); g++) {
+            for (int row : table.getGroup(g)) {
+                groupSums[g] += this->right[i+1][row];
+            }
+        }
+
+        for (int r = 0; r < relations[i].getRowCount(); r++) {
+            int g = table.findGroup(thisKeyCols, r);
+            this->right[i][r] = g == -1 ? 0 : groupSums[g];
+        }
+    }
+}
+
+/*
+ * COUNT(*) of the line join.
+ */
+long long lineJoinAggregate::count() const {
+    long long res = 0;
+
+    if (!this->right.empty()) {
+        for (long long w : this->right[0]) {
+            res += w;
+        }
+    }
+
+    return res;
+}
+
+/*
+ * SUM(attr) over all result tuples.
+ */
+long long lineJoinAggregate::sum(const string& attr) const {
+    int rel, col;
+    this->locate(attr, rel, col);
+    columnSpan vals = this->relations[rel].getColumn(col);
+    long long res = 0;
+
+    for (int r = 0; r < vals.size; r++) {
+        res += vals[r] * this->weight(rel, r);
+    }
+
+    return res;
+}
+
+/*
+ * MIN(attr) over all result tuples, or INT_MAX if the result is empty.
+ */
+int lineJoinAggregate::min(const string& attr) const {
+    int rel, col;
+    this->locate(attr, rel, col);
+    columnSpan vals = this->relations[rel].getColumn(col);
+    int res = INT_MAX;
+
+    for (int r = 0; r < vals.size; r++) {
+        if (vals[r] < res && this->weight(rel, r) > 0) {
+            res = vals[r];
+        }
+    }
+
+    return res;
+}
+
+/*
+ * MAX(attr) over all result tuples, or INT_MIN if the result is empty.
+ */
+int lineJoinAggregate::max(const string& attr) const {
+    int rel, col;
+    this->locate(attr, rel, col);
+    columnSpan vals = this->relations[rel].getColumn(col);
+    int res = INT_MIN;
+
+    for (int r = 0; r < vals.size; r++) {
+        if (vals[r] > res && this->weight(rel, r) > 0) {
+            res = vals[r];
+        }
+    }
+
+    return res;
+}
+
+/*
+ * SELECT attr, COUNT(*) ... GROUP BY attr. Values not occurring in the result are left out.
+ */
+unordered_map<int, long long> lineJoinAggregate::countBy(const string& attr) const {
+    int rel, col;
+    this->locate(attr, rel, col);
+    columnSpan vals = this->relations[rel].getColumn(col);
+    unordered_map<int, long long> res;
+
+    for (int r = 0; r < vals.size; r++) {
+        long long w = this->weight(rel, r);
+        if (w > 0) {
+            res[vals[r]] += w;
+        }
+    }
+
+    return res;
+}
+
+/*
+ * Private functions
+ */
+
+/*
+ * Finds the first relation holding attr. Any relation holding it would do, since joined rows agree on it.
+ */
+void lineJoinAggregate::locate(const string& attr, int& rel, int& col) const {
+    for (rel = 0; rel < this->relations.size(); rel++) {
+        col = this->relations[rel].getColumnIndex(attr);
+        if (col != -1) {
+            return;
+        }
+    }
+
+    throw std::invalid_argument("Unknown attribute " + attr + "!");
+}
+
+long long lineJoinAggregate::weight(int rel, int row) const {
+    return this->left[rel][row] * this->right[rel][row];
+}
@@ -0,0 +1,41 @@
+#ifndef PROJECT_LINEJOINAGGREGATE_H
+#define PROJECT_LINEJOINAGGREGATE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Aggregates over the line join query q(A1, ... , Ak+1) :- R1(A1, A2), ..., Rk(Ak, Ak+1) computed without
+ * enumerating the join. Two linear passes annotate every row with the number of partial results ending in it
+ * (head to tail) and starting in it (tail to head), using the counting semiring in place of the boolean
+ * semi-joins of the Yannakakis algorithm. The product of the two annotations is the number of result tuples
+ * the row takes part in, from which COUNT(*), SUM, MIN, MAX and grouped counts over any attribute follow in
+ * one scan of the relation holding it. Construction and every aggregate run in O(N), independent of OUT.
+ * The object keeps copies of the relations, which share their storage.
+ */
+class lineJoinAggregate {
+    public:
+        explicit lineJoinAggregate(const vector<relation>& relations);
+        long long count() const;
+        long long sum(const string& attr) const;
+        int min(const string& attr) const;
+        int max(const string& attr) const;
+        unordered_map<int, long long> countBy(const string& attr) const;
+
+    private:
+        void locate(const string& attr, int& rel, int& col) const;
+        long long weight(int rel, int row) const;
+
+        /* properties */
+        vector<relation> relations;
+        // left[i][r]: partial results over R1 .. Ri ending in row r of Ri
+        // right[i][r]: partial results over Ri .. Rk starting in row r of Ri
+        vector<vector<long long>> left;
+        vector<vector<long long>> right;
+};
+
+#endif //PROJECT_LINEJOINAGGREGATE_H
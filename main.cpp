@@ -19,6 +19,9 @@ typedef std::chrono::high_resolution_clock::time_point TimeVar;
 #define duration(a) std::chrono::duration_cast<std::chrono::microseconds>(a).count()
 #define timeNow() std::chrono::high_resolution_clock::now()
 
+// picks the overloads of the line join methods taking no predicates
+typedef relation (*lineJoinFunction)(const vector<relation>&);
+
 /*
  * Returns the amount of time taken to execute a function in microseconds and stores
  * the return value of func into result.
@@ -355,18 +358,18 @@ void executeProblem4Experiments() {
     vector<relation> lineQuery{r1, r2, r3};
     // Measure time taken for line join query (problem 2)
     relation lineJoinResult;
-    double timeLineJoin = funcTime(relation::executeLineJoin, lineJoinResult, lineQuery);
+    double timeLineJoin = funcTime<lineJoinFunction>(relation::executeLineJoin, lineJoinResult, lineQuery);
 
     // Measure time taken for line join query by chaining (problem 3)
     relation lineJoinByChainingResult;
-    double timeLineJoinByChaining = funcTime(relation::executeLineJoinByChaining, lineJoinByChainingResult, lineQuery);
+    double timeLineJoinByChaining = funcTime<lineJoinFunction>(relation::executeLineJoinByChaining, lineJoinByChainingResult, lineQuery);
 
     cout << "Time taken for line join (Problem 2): " << timeLineJoin << " microseconds." << endl;
     cout << "Time taken for line join by chaining (Problem 3): " << timeLineJoinByChaining << " microseconds."  << endl;
 
     cout << endl;
 
-    if (lineJoinResult.getData() == lineJoinByChainingResult.getData()) {
+    if (lineJoinResult == lineJoinByChainingResult) {
         cout << "The two methods of executing the query produced equivalent results." << endl;
     } else {
         cout << "The two methods of executing the query did not produced equivalent results." << endl;
@@ -450,18 +453,18 @@ void executeProblem5Experiments() {
     vector<relation> lineQuery{r1, r2, r3};
     // Measure time taken for line join query (problem 2)
     relation lineJoinResult;
-    double timeLineJoin = funcTime(relation::executeLineJoin, lineJoinResult, lineQuery);
+    double timeLineJoin = funcTime<lineJoinFunction>(relation::executeLineJoin, lineJoinResult, lineQuery);
 
     // Measure time taken for line join query by chaining (problem 3)
     relation lineJoinByChainingResult;
-    double timeLineJoinByChaining = funcTime(relation::executeLineJoinByChaining, lineJoinByChainingResult, lineQuery);
+    double timeLineJoinByChaining = funcTime<lineJoinFunction>(relation::executeLineJoinByChaining, lineJoinByChainingResult, lineQuery);
 
     cout << "Time taken for line join (Problem 2): " << timeLineJoin << " microseconds." << endl;
     cout << "Time taken for line join by chaining (Problem 3): " << timeLineJoinByChaining << " microseconds."  << endl;
 
     cout << endl;
 
-    if (lineJoinResult.getData() == lineJoinByChainingResult.getData()) {
+    if (lineJoinResult == lineJoinByChainingResult) {
         cout << "The two methods of executing the query produced equivalent results." << endl;
     } else {
         cout << "The two methods of executing the query did not produced equivalent results." << endl;
@@ -0,0 +1,171 @@
+#include <cstdlib>
+#include "memoryTracker.h"
+#include "queryProfile.h"
+
+static thread_local memoryAccount* activeAccount = nullptr;
+
+// every tracked block is preceded by the account it was charged to, its size and the distance from the start
+// of the underlying allocation; the header takes 32 bytes, keeping the data 16-byte aligned
+struct blockHeader {
+    memoryAccount* account;
+    size_t bytes;
+    size_t offset;
+};
+static const size_t headerSize = 32;
+static_assert(sizeof(blockHeader) <= headerSize, "block header does not fit");
+
+/*
+ * Adds bytes to the account, throwing memoryLimitExceeded instead if that would exceed the limit.
+ */
+void memoryAccount::charge(long long bytes) {
+    lock_guard<mutex> guard(this->lock);
+
+    if (this->limit != -1 && this->current + bytes > this->limit) {
+        const char* op = queryProfile::currentOperator();
+        throw memoryLimitExceeded("Memory limit of " + to_string(this->limit) + " bytes exceeded"
+                                  + (op ? " in " + string(op) : "") + " (" + to_string(this->current)
+                                  + " bytes in use, " + to_string(bytes) + " requested)!");
+    }
+
+    this->current += bytes;
+    this->allocated += bytes;
+    this->refs++;
+    if (this->current > this->peak) {
+        const char* op = queryProfile::currentOperator();
+        this->peak = this->current;
+        this->peakOperator = op ? op : "";
+    }
+}
+
+/*
+ * Removes bytes and one reference from the account, deleting it with the last reference.
+ */
+void memoryAccount::release(long long bytes) {
+    bool last;
+    {
+        lock_guard<mutex> guard(this->lock);
+        this->current -= bytes;
+        last = --this->refs == 0;
+    }
+
+    if (last) {
+        delete this;
+    }
+}
+
+memoryLimitExceeded::memoryLimitExceeded(const string& message) : message(message) {}
+
+const char* memoryLimitExceeded::what() const noexcept {
+    return this->message.c_str();
+}
+
+/*
+ * limit is the budget in bytes, or -1 for none.
+ */
+memoryTracker::memoryTracker(long long limit, bool allowFallback) {
+    this->account = new memoryAccount();
+    this->account->limit = limit;
+    this->account->allowFallback = allowFallback;
+}
+
+memoryTracker::~memoryTracker() {
+    this->disable();
+    this->account->release(0);
+}
+
+/*
+ * Starts charging the calling thread's tracked allocations to this tracker, replacing any other tracker
+ * enabled on the thread.
+ */
+void memoryTracker::enable() {
+    activeAccount = this->account;
+}
+
+void memoryTracker::disable() {
+    if (activeAccount == this->account) {
+        activeAccount = nullptr;
+    }
+}
+
+long long memoryTracker::getCurrent() const {
+    lock_guard<mutex> guard(this->account->lock);
+    return this->account->current;
+}
+
+long long memoryTracker::getPeak() const {
+    lock_guard<mutex> guard(this->account->lock);
+    return this->account->peak;
+}
+
+long long memoryTracker::getLimit() const {
+    return this->account->limit;
+}
+
+/*
+ * Name of the innermost operator running when the peak was reached, or "" if it was not inside an operator.
+ */
+string memoryTracker::getPeakOperator() const {
+    lock_guard<mutex> guard(this->account->lock);
+    return this->account->peakOperator;
+}
+
+memoryAccount* memoryTracker::currentAccount() {
+    return activeAccount;
+}
+
+/*
+ * Makes the calling thread charge account; used to extend a query's tracker to its worker threads.
+ */
+void memoryTracker::setCurrentAccount(memoryAccount* account) {
+    activeAccount = account;
+}
+
+/*
+ * Whether the tracker enabled on the calling thread lets operators retry with a lower-memory strategy.
+ */
+bool memoryTracker::fallbackAllowed() {
+    return activeAccount != nullptr && activeAccount->allowFallback;
+}
+
+/*
+ * Allocates bytes aligned to alignment (a power of two), charged to the calling thread's account.
+ */
+void* trackedAllocate(size_t bytes, size_t alignment) {
+    memoryAccount* account = activeAccount;
+    if (account != nullptr) {
+        account->charge(bytes);
+    }
+
+    // over-aligned data starts at the first multiple of alignment leaving room for the header
+    size_t offset = alignment <= 16 ? headerSize : (headerSize + alignment - 1) & ~(alignment - 1);
+    void* block = nullptr;
+    if (alignment <= 16) {
+        block = malloc(offset + bytes);
+    } else if (posix_memalign(&block, alignment, offset + bytes) != 0) {
+        block = nullptr;
+    }
+
+    if (block == nullptr) {
+        if (account != nullptr) {
+            account->release(bytes);
+        }
+        throw bad_alloc();
+    }
+
+    char* data = (char*)block + offset;
+    *(blockHeader*)(data - headerSize) = blockHeader{account, bytes, offset};
+    return data;
+}
+
+void trackedDeallocate(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    blockHeader header = *(blockHeader*)((char*)ptr - headerSize);
+    free((char*)ptr - header.offset);
+
+    if (header.account != nullptr) {
+        header.account->release(header.bytes);
+    }
+}
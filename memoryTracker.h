@@ -0,0 +1,110 @@
+#ifndef PROJECT_MEMORYTRACKER_H
+#define PROJECT_MEMORYTRACKER_H
+
+#include <new>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+/*
+ * Counters shared by a memoryTracker and the allocations charged to it. Every live allocation holds a
+ * reference, so relations that outlive their query can still release their bytes safely.
+ */
+struct memoryAccount {
+    mutex lock;
+    long long current = 0;
+    long long peak = 0;
+    long long allocated = 0;       // bytes charged in total, freed or not
+    long long limit = -1;          // -1 means unlimited
+    bool allowFallback = false;
+    string peakOperator;
+    long long refs = 1;            // the tracker plus one per live allocation
+
+    void charge(long long bytes);
+    void release(long long bytes);
+};
+
+/*
+ * Thrown by a tracked allocation that would take its query over the memory budget.
+ */
+class memoryLimitExceeded : public bad_alloc {
+    public:
+        explicit memoryLimitExceeded(const string& message);
+        const char* what() const noexcept override;
+
+    private:
+        string message;
+};
+
+/*
+ * Per-query memory accounting. While a tracker is enabled on a thread, every tracked allocation made by that
+ * thread (and by the workers of parallelFor calls it makes) is charged to it: relation columns, hash tables and
+ * join buffers. It keeps the current and peak byte counts and the operator running at the peak (see
+ * profileScope). With a limit, an allocation that would exceed it throws memoryLimitExceeded before anything
+ * is allocated; with fallback allowed, operators that have a lower-memory strategy switch to it instead.
+ */
+class memoryTracker {
+    public:
+        explicit memoryTracker(long long limit = -1, bool allowFallback = false);
+        ~memoryTracker();
+        void enable();
+        void disable();
+        long long getCurrent() const;
+        long long getPeak() const;
+        long long getLimit() const;
+        string getPeakOperator() const;
+
+        memoryTracker(const memoryTracker&) = delete;
+        memoryTracker& operator=(const memoryTracker&) = delete;
+
+        static memoryAccount* currentAccount();
+        static void setCurrentAccount(memoryAccount* account);
+        static bool fallbackAllowed();
+
+    private:
+        /* properties */
+        memoryAccount* account;
+};
+
+void* trackedAllocate(size_t bytes, size_t alignment = alignof(max_align_t));
+void trackedDeallocate(void* ptr);
+
+/*
+ * Allocator charging the thread's current memoryTracker, if any. Each block remembers the account it was
+ * charged to, so it may be freed on any thread, after the query, or after the tracker is gone.
+ */
+template<typename T>
+struct trackedAllocator {
+    typedef T value_type;
+
+    trackedAllocator() = default;
+
+    template<typename U>
+    trackedAllocator(const trackedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return (T*)trackedAllocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(T* ptr, size_t) {
+        trackedDeallocate(ptr);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const trackedAllocator<T>&, const trackedAllocator<U>&) {
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const trackedAllocator<T>&, const trackedAllocator<U>&) {
+    return false;
+}
+
+template<typename T>
+using trackedVector = vector<T, trackedAllocator<T>>;
+
+#endif //PROJECT_MEMORYTRACKER_H
@@ -0,0 +1,65 @@
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+#include "memoryTracker.h"
+#include "queryProfile.h"
+
+void parallelFor(int taskCount, unsigned int threadCount, const function<void(int, int)>& task) {
+    if (threadCount > (unsigned int)taskCount) {
+        threadCount = taskCount;
+    }
+
+    if (threadCount <= 1) {
+        for (int t = 0; t < taskCount; t++) {
+            task(t, 0);
+        }
+        return;
+    }
+
+    atomic<int> next(0);
+    exception_ptr error;
+    mutex errorLock;
+    // workers charge the caller's memory tracker and carry the caller's operator label
+    memoryAccount* account = memoryTracker::currentAccount();
+    const char* op = queryProfile::currentOperator();
+
+    auto worker = [&](int id) {
+        memoryTracker::setCurrentAccount(account);
+        queryProfile::setCurrentOperator(op);
+
+        try {
+            for (int t = next++; t < taskCount; t = next++) {
+                task(t, id);
+            }
+        } catch (...) {
+            lock_guard<mutex> guard(errorLock);
+            if (!error) {
+                error = current_exception();
+            }
+            // stop handing out tasks
+            next = taskCount;
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned int i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+
+    for (thread& t : threads) {
+        t.join();
+    }
+
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+unsigned int defaultThreadCount() {
+    unsigned int n = thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
@@ -0,0 +1,21 @@
+#ifndef PROJECT_PARALLEL_H
+#define PROJECT_PARALLEL_H
+
+#include <functional>
+
+using namespace std;
+
+/*
+ * Runs task(t, worker) for every t in [0, taskCount) on up to threadCount threads, the calling thread
+ * included. Tasks are handed out dynamically; worker lies in [0, threadCount) and identifies the thread
+ * running the task, so callers can keep per-thread buffers without locking. The first exception thrown by
+ * a task is rethrown once all threads have finished. Worker threads charge the caller's memoryTracker.
+ */
+void parallelFor(int taskCount, unsigned int threadCount, const function<void(int, int)>& task);
+
+/*
+ * Number of hardware threads, or 1 if it cannot be determined.
+ */
+unsigned int defaultThreadCount();
+
+#endif //PROJECT_PARALLEL_H
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <climits>
+#include "predicate.h"
+#include "simdKernels.h"
+
+// rows evaluated per call of the range kernel
+static const int batchSize = 1024;
+
+/*
+ * attr op val, e.g. predicate("A", predicate::less, 1000) for A < 1000.
+ */
+predicate::predicate(const string& attr, comparison op, int val) {
+    this->attribute = attr;
+    this->type = rangeKind;
+    this->lo = INT_MIN;
+    this->hi = INT_MAX;
+
+    switch (op) {
+        case equal:
+            this->lo = this->hi = val;
+            break;
+        case notEqual:
+            this->type = notRangeKind;
+            this->lo = this->hi = val;
+            break;
+        case less:
+            this->type = val == INT_MIN ? noneKind : rangeKind;
+            this->hi = val - (val != INT_MIN);
+            break;
+        case lessEqual:
+            this->hi = val;
+            break;
+        case greater:
+            this->type = val == INT_MAX ? noneKind : rangeKind;
+            this->lo = val + (val != INT_MAX);
+            break;
+        case greaterEqual:
+            this->lo = val;
+            break;
+    }
+}
+
+predicate::predicate(const string& attr, kind k, int lo, int hi) {
+    this->attribute = attr;
+    this->type = k;
+    this->lo = lo;
+    this->hi = hi;
+}
+
+/*
+ * lo <= attr <= hi; empty if lo > hi.
+ */
+predicate predicate::range(const string& attr, int lo, int hi) {
+    return predicate(attr, lo <= hi ? rangeKind : noneKind, lo, hi);
+}
+
+/*
+ * attr IN (vals); empty if vals is.
+ */
+predicate predicate::in(const string& attr, const vector<int>& vals) {
+    predicate res(attr, vals.empty() ? noneKind : inKind, 0, 0);
+    res.vals = vals;
+    sort(res.vals.begin(), res.vals.end());
+    res.vals.erase(unique(res.vals.begin(), res.vals.end()), res.vals.end());
+    return res;
+}
+
+const string& predicate::getAttribute() const {
+    return this->attribute;
+}
+
+/*
+ * Evaluates the predicate on col[rows[0]], ..., col[rows[count - 1]] (on col[0], ..., col[count - 1] if rows
+ * is null) and writes the ids of the qualifying rows to out, in the given order. Returns their number.
+ * out may be rows itself, so that a selection vector is refined in place by a conjunction of predicates.
+ */
+int predicate::select(columnSpan col, const int* rows, int count, int* out) const {
+    int vals[batchSize], idxs[batchSize];
+    int selected = 0;
+
+    if (this->type == noneKind) {
+        return 0;
+    }
+
+    for (int start = 0; start < count; start += batchSize) {
+        int n = min(batchSize, count - start);
+        const int* batch = col.data + start;
+        if (rows != nullptr) {
+            simdKernels::gather(col, rows + start, n, vals);
+            batch = vals;
+        }
+
+        int matches = 0;
+        if (this->type == inKind) {
+            for (int i = 0; i < n; i++) {
+                idxs[matches] = i;
+                matches += binary_search(this->vals.begin(), this->vals.end(), batch[i]);
+            }
+        } else {
+            matches = simdKernels::selectRange(batch, n, this->lo, this->hi, this->type == notRangeKind, idxs);
+        }
+
+        // the ids written never pass the ids still to be read, so out may alias rows
+        for (int j = 0; j < matches; j++) {
+            out[selected++] = rows != nullptr ? rows[start + idxs[j]] : start + idxs[j];
+        }
+    }
+
+    return selected;
+}
+
+string predicate::toString() const {
+    switch (this->type) {
+        case noneKind:
+            return "FALSE";
+        case notRangeKind:
+            return this->attribute + " <> " + to_string(this->lo);
+        case inKind: {
+            string res = this->attribute + " IN (";
+            for (int i = 0; i < this->vals.size(); i++) {
+                res += (i == 0 ? "" : ", ") + to_string(this->vals[i]);
+            }
+            return res + ")";
+        }
+        default:
+            if (this->lo == this->hi) {
+                return this->attribute + " = " + to_string(this->lo);
+            } else if (this->lo == INT_MIN) {
+                return this->attribute + " <= " + to_string(this->hi);
+            } else if (this->hi == INT_MAX) {
+                return this->attribute + " >= " + to_string(this->lo);
+            }
+            return this->attribute + " BETWEEN " + to_string(this->lo) + " AND " + to_string(this->hi);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PROJECT_PREDICATE_H
+#define PROJECT_PREDICATE_H
+
+#include <string>
+#include <vector>
+#include "columnSpan.h"
+
+using namespace std;
+
+/*
+ * Selection predicate on one attribute: a comparison with a constant, an inclusive range or an IN list.
+ * Predicates are evaluated a batch of rows at a time into selection vectors (the ids of the qualifying rows),
+ * comparisons and ranges with the vectorized range kernel of simdKernels. A list of predicates passed to
+ * relation::select or to the line join methods is their conjunction.
+ */
+class predicate {
+    public:
+        enum comparison { equal, notEqual, less, lessEqual, greater, greaterEqual };
+
+        predicate(const string& attr, comparison op, int val);
+        static predicate range(const string& attr, int lo, int hi);
+        static predicate in(const string& attr, const vector<int>& vals);
+        const string& getAttribute() const;
+        int select(columnSpan col, const int* rows, int count, int* out) const;
+        string toString() const;
+
+    private:
+        enum kind { rangeKind, notRangeKind, inKind, noneKind };
+
+        predicate(const string& attr, kind k, int lo, int hi);
+
+        /* properties */
+        string attribute;
+        kind type;
+        int lo;             // bounds of the (negated) range, inclusive
+        int hi;
+        vector<int> vals;   // sorted, duplicate-free IN list
+};
+
+#endif //PROJECT_PREDICATE_H
@@ -0,0 +1,213 @@
+#include <sstream>
+#include <iomanip>
+#include "queryProfile.h"
+#include "memoryTracker.h"
+#include "relation.h"
+
+static thread_local queryProfile* activeProfile = nullptr;
+static thread_local const char* activeOperator = nullptr;
+
+queryProfile::queryProfile() {
+    this->account = new memoryAccount();
+}
+
+queryProfile::~queryProfile() {
+    this->disable();
+    this->account->release(0);
+}
+
+/*
+ * Starts recording the operators run by the calling thread into this profile, replacing any other profile
+ * enabled on the thread.
+ */
+void queryProfile::enable() {
+    activeProfile = this;
+}
+
+void queryProfile::disable() {
+    if (activeProfile == this) {
+        activeProfile = nullptr;
+    }
+}
+
+void queryProfile::clear() {
+    this->operators.clear();
+    this->roots.clear();
+    this->open.clear();
+}
+
+const vector<operatorProfile>& queryProfile::getOperators() const {
+    return this->operators;
+}
+
+/*
+ * Returns the profile enabled on the calling thread, or nullptr.
+ */
+queryProfile* queryProfile::current() {
+    return activeProfile;
+}
+
+/*
+ * Returns the name of the innermost operator running on the calling thread, or nullptr.
+ */
+const char* queryProfile::currentOperator() {
+    return activeOperator;
+}
+
+/*
+ * Labels the calling thread as running the given operator; used to extend an operator's label to its workers.
+ */
+void queryProfile::setCurrentOperator(const char* name) {
+    activeOperator = name;
+}
+
+/*
+ * One line per operator, children indented under their caller, e.g.
+ *   executeLineJoin  2.104 ms  in [1000, 1000]  out 350  bytes 4200
+ *     semiJoin  0.210 ms  in [1000, 1000]  out 600  build 1000  probes 1000  matches 600  bytes 30560
+ */
+string queryProfile::toString() const {
+    string str;
+
+    for (int root : this->roots) {
+        str += this->nodeToString(root, 0);
+    }
+    return str;
+}
+
+string queryProfile::nodeToString(int node, int depth) const {
+    const operatorProfile& op = this->operators[node];
+    stringstream out;
+
+    out << string(2 * depth, ' ') << op.name << "  " << fixed << setprecision(3) << op.wallMicros / 1000 << " ms";
+    if (!op.inputRows.empty()) {
+        out << "  in [";
+        for (int i = 0; i < op.inputRows.size(); i++) {
+            out << (i == 0 ? "" : ", ") << op.inputRows[i];
+        }
+        out << "]";
+    }
+    if (op.outputRows != -1) {
+        out << "  out " << op.outputRows;
+    }
+    if (op.buildRows != -1) {
+        out << "  build " << op.buildRows;
+    }
+    if (op.probes != -1) {
+        out << "  probes " << op.probes << "  matches " << op.matches;
+    }
+    if (op.bytesAllocated != 0) {
+        out << "  bytes " << op.bytesAllocated;
+    }
+    out << "\n";
+
+    for (int child : op.children) {
+        out << this->nodeToString(child, depth + 1);
+    }
+    return out.str();
+}
+
+/*
+ * Array of the top-level operators; every operator is an object whose "children" hold the operators it called.
+ */
+string queryProfile::toJson() const {
+    string json = "[";
+
+    for (int i = 0; i < this->roots.size(); i++) {
+        json += (i == 0 ? "\n" : ",\n") + this->nodeToJson(this->roots[i], 1);
+    }
+    return json + (this->roots.empty() ? "]" : "\n]");
+}
+
+string queryProfile::nodeToJson(int node, int depth) const {
+    const operatorProfile& op = this->operators[node];
+    string indent(2 * depth, ' ');
+    stringstream out;
+
+    out << indent << "{\"name\": \"" << op.name << "\", \"wall_us\": " << fixed << setprecision(3) << op.wallMicros
+        << ", \"input_rows\": [";
+    for (int i = 0; i < op.inputRows.size(); i++) {
+        out << (i == 0 ? "" : ", ") << op.inputRows[i];
+    }
+    out << "], \"output_rows\": " << op.outputRows << ", \"build_rows\": " << op.buildRows
+        << ", \"probes\": " << op.probes << ", \"matches\": " << op.matches
+        << ", \"bytes_allocated\": " << op.bytesAllocated << ", \"children\": [";
+
+    for (int i = 0; i < op.children.size(); i++) {
+        out << (i == 0 ? "\n" : ",\n") << this->nodeToJson(op.children[i], depth + 1);
+    }
+    out << (op.children.empty() ? "]}" : "\n" + indent + "]}");
+    return out.str();
+}
+
+#ifndef PROJECT_NO_PROFILING
+
+static long long getAllocated(memoryAccount* account) {
+    lock_guard<mutex> guard(account->lock);
+    return account->allocated;
+}
+
+profileScope::profileScope(const char* name) {
+    this->profile = activeProfile;
+    this->index = -1;
+    this->previousOperator = activeOperator;
+    activeOperator = name;
+
+    if (this->profile) {
+        operatorProfile op;
+        op.name = name;
+        op.parent = this->profile->open.empty() ? -1 : this->profile->open.back();
+
+        this->index = this->profile->operators.size();
+        this->profile->operators.push_back(op);
+        if (op.parent == -1) {
+            this->profile->roots.push_back(this->index);
+        } else {
+            this->profile->operators[op.parent].children.push_back(this->index);
+        }
+        this->profile->open.push_back(this->index);
+
+        this->previousAccount = memoryTracker::currentAccount();
+        this->account = this->previousAccount ? this->previousAccount : this->profile->account;
+        memoryTracker::setCurrentAccount(this->account);
+        this->allocatedBefore = getAllocated(this->account);
+        this->start = chrono::steady_clock::now();
+    }
+}
+
+profileScope::~profileScope() {
+    activeOperator = this->previousOperator;
+
+    if (this->profile) {
+        this->node().wallMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - this->start).count();
+        this->node().bytesAllocated = getAllocated(this->account) - this->allocatedBefore;
+        memoryTracker::setCurrentAccount(this->previousAccount);
+        this->profile->open.pop_back();
+    }
+}
+
+void profileScope::recordInput(const relation& r) {
+    this->node().inputRows.push_back(r.getRowCount());
+}
+
+void profileScope::recordOutput(const relation& r) {
+    this->node().outputRows = r.getRowCount();
+}
+
+void profileScope::recordProbes(long long probes, long long matches) {
+    this->node().probes = probes;
+    this->node().matches = matches;
+}
+
+#else
+
+profileScope::profileScope(const char* name) {
+    this->previousOperator = activeOperator;
+    activeOperator = name;
+}
+
+profileScope::~profileScope() {
+    activeOperator = this->previousOperator;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PROJECT_QUERYPROFILE_H
+#define PROJECT_QUERYPROFILE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+class relation;
+struct memoryAccount;
+
+/*
+ * Measurements of one operator invocation. Counters that do not apply to the operator are -1.
+ */
+struct operatorProfile {
+    string name;
+    double wallMicros = 0;
+    vector<long long> inputRows;
+    long long outputRows = -1;
+    long long buildRows = -1;      // rows inserted into a hash table or filter
+    long long probes = -1;         // lookups into that hash table or filter
+    long long matches = -1;        // lookups that found a partner (or tuples produced by them)
+    long long bytesAllocated = 0;  // tracked allocations made while it ran, by itself, its children and workers
+    int parent = -1;
+    vector<int> children;
+};
+
+/*
+ * EXPLAIN ANALYZE-style profile of the operators run by one thread.
+ * While a profile is enabled, every instrumented operator the thread runs records an operatorProfile, nested
+ * under the operator that called it; the profile can then be printed as a tree or exported as JSON.
+ * bytesAllocated is measured as the growth of the query's memoryAccount total (see memoryTracker) over the
+ * operator's run; without an enabled memoryTracker, the profile charges the allocations to an unlimited account
+ * of its own. Allocations that are not tracked (see trackedVector) are not counted.
+ * With no profile enabled, an instrumented operator only updates two thread-local pointers, the profile and
+ * the name of the innermost running operator (used by memoryTracker). Building with PROJECT_NO_PROFILING
+ * defined compiles the recording out; operators still maintain the name of the innermost running operator, so
+ * memoryTracker keeps attributing its peak and budget errors.
+ */
+class queryProfile {
+    public:
+        queryProfile();
+        ~queryProfile();
+        queryProfile(const queryProfile&) = delete;
+        queryProfile& operator=(const queryProfile&) = delete;
+        void enable();
+        void disable();
+        void clear();
+        const vector<operatorProfile>& getOperators() const;
+        string toString() const;
+        string toJson() const;
+
+        static queryProfile* current();
+        static const char* currentOperator();
+        static void setCurrentOperator(const char* name);
+
+    private:
+        friend class profileScope;
+
+        string nodeToString(int node, int depth) const;
+        string nodeToJson(int node, int depth) const;
+
+        /* properties */
+        vector<operatorProfile> operators;   // in the order the operators started
+        vector<int> roots;
+        vector<int> open;                    // operators that have started but not finished, innermost last
+        memoryAccount* account;              // charged by operators running without a memoryTracker
+};
+
+/*
+ * Records one operator invocation into the current thread's profile, from construction to destruction.
+ * Apart from labelling the thread with the operator's name, every method is a no-op when no profile is enabled.
+ */
+class profileScope {
+    public:
+#ifndef PROJECT_NO_PROFILING
+        explicit profileScope(const char* name);
+        ~profileScope();
+        bool active() const { return this->profile != nullptr; }
+        void addInput(const relation& r) { if (this->profile) this->recordInput(r); }
+        void setOutput(const relation& r) { if (this->profile) this->recordOutput(r); }
+        void setBuild(long long rows) { if (this->profile) this->node().buildRows = rows; }
+        void setProbes(long long probes, long long matches) { if (this->profile) this->recordProbes(probes, matches); }
+        void addInputRows(long long rows) { if (this->profile) this->node().inputRows.push_back(rows); }
+        void setOutputRows(long long rows) { if (this->profile) this->node().outputRows = rows; }
+#else
+        explicit profileScope(const char* name);
+        ~profileScope();
+        bool active() const { return false; }
+        void addInput(const relation&) {}
+        void setOutput(const relation&) {}
+        void setBuild(long long) {}
+        void setProbes(long long, long long) {}
+        void addInputRows(long long) {}
+        void setOutputRows(long long) {}
+#endif
+
+        profileScope(const profileScope&) = delete;
+        profileScope& operator=(const profileScope&) = delete;
+
+    private:
+#ifndef PROJECT_NO_PROFILING
+        operatorProfile& node() { return this->profile->operators[this->index]; }
+        void recordInput(const relation& r);
+        void recordOutput(const relation& r);
+        void recordProbes(long long probes, long long matches);
+
+        /* properties */
+        queryProfile* profile;
+        int index;
+        chrono::steady_clock::time_point start;
+        memoryAccount* account;
+        memoryAccount* previousAccount;
+        long long allocatedBefore;
+#endif
+        const char* previousOperator;
+};
+
+#endif //PROJECT_QUERYPROFILE_H
@@ -6,31 +6,54 @@
 #include <unordered_map>
 #include <climits>
 #include "relation.h"
+#include "joinHashTable.h"
+#include "bloomFilter.h"
+#include "parallel.h"
+#include "factorizedResult.h"
+#include "joinTree.h"
+#include "leapfrogTriejoin.h"
+#include "joinPlanner.h"
+#include "queryProfile.h"
+#include "simdKernels.h"
 
 relation::relation() {
     this->name = "";
+    this->rowCount = 0;
+    this->rowOffset = 0;
+    this->statsMaintained = true;
 }
 
 relation::relation(const string& n) {
     this->name = n;
+    this->rowCount = 0;
+    this->rowOffset = 0;
+    this->statsMaintained = true;
 }
 
 relation::relation(vector<string>& attrs) {
     this->name = "";
+    this->rowCount = 0;
+    this->rowOffset = 0;
+    this->statsMaintained = true;
 
     int idx = 0;
     for (string attr : attrs) {
         this->attributes.emplace(attr, idx);
+        this->columns.push_back(make_shared<trackedVector<int>>());
         idx++;
     }
 }
 
 relation::relation(const string& n, vector<string>& attrs) {
     this->name = n;
+    this->rowCount = 0;
+    this->rowOffset = 0;
+    this->statsMaintained = true;
 
     int idx = 0;
     for (string attr : attrs) {
         this->attributes.emplace(attr, idx);
+        this->columns.push_back(make_shared<trackedVector<int>>());
         idx++;
     }
 }
@@ -38,7 +61,16 @@ relation::relation(const string& n, vector<string>& attrs) {
 relation::relation(const relation& other) {
     this->name = other.name;
     this->attributes = other.attributes;
-    this->data = other.data;
+    this->columns = other.columns;
+    this->rowCount = other.rowCount;
+    this->selection = other.selection;
+    this->rowOffset = other.rowOffset;
+    this->gathered = other.gathered;
+    this->sortedIndexes = other.sortedIndexes;
+    this->stats = other.stats;
+    this->statsMaintained = other.statsMaintained;
+    this->mapping = other.mapping;
+    this->mappedColumns = other.mappedColumns;
 }
 
 relation::~relation() = default;
@@ -52,7 +84,7 @@ void relation::setName(string n) {
 }
 
 int relation::getRowCount() const {
-    return this->data.size();
+    return this->rowCount;
 }
 
 int relation::getColumnCount() const {
@@ -79,14 +111,14 @@ vector<string> relation::getAttributes() const {
 }
 
 bool relation::addAttribute(const string& attr) {
+    this->makeWritable();
+
     if (this->attributes.count(attr) == 0) {
         int colCount = this->getColumnCount();
 
         this->attributes.emplace(attr, colCount);
-
-        for (auto row : this->data) {
-            row.push_back(0);
-        }
+        this->columns.push_back(make_shared<trackedVector<int>>(this->rowCount, 0));
+        this->stats.reset();
 
         return true;
     }
@@ -94,6 +126,7 @@ bool relation::addAttribute(const string& attr) {
 }
 
 bool relation::addAttributes(vector<string>& attrs) {
+    this->makeWritable();
     int colCount = this->getColumnCount();
 
     // Check that all strings in attrs do not already exist as attributes in relation
@@ -105,60 +138,438 @@ bool relation::addAttributes(vector<string>& attrs) {
 
     for (string attr : attrs) {
         this->attributes.emplace(attr, colCount);
-
-        for (auto row : this->data) {
-            row.push_back(0);
-        }
+        this->columns.push_back(make_shared<trackedVector<int>>(this->rowCount, 0));
 
         colCount++;
     }
+    this->stats.reset();
 
     return true;
 }
 
 vector<vector<int>> relation::getData() const {
-    return this->data;
+    vector<vector<int>> rows(this->rowCount, vector<int>(this->getColumnCount()));
+
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        columnSpan col = this->getColumn(c);
+
+        for (int i = 0; i < this->rowCount; i++) {
+            rows[i][c] = col[i];
+        }
+    }
+
+    return rows;
 }
 
 void relation::insertTuple(vector<int>& tup) {
+    this->makeWritable();
+
     if (tup.size() == this->getColumnCount()) {
-        this->data.push_back(tup);
+        vector<columnStats>* stats = this->getMaintainedStatistics();
+        for (int c = 0; c < this->getColumnCount(); c++) {
+            this->columns[c]->push_back(tup[c]);
+        }
+        this->rowCount++;
+        this->sortedIndexes.clear();
+
+        if (stats != nullptr) {
+            for (int c = 0; c < this->getColumnCount(); c++) {
+                (*stats)[c].add(tup[c]);
+            }
+        } else {
+            this->stats.reset();
+        }
     }
 }
 
-const vector<int>& relation::getTuple(unsigned int idx) const {
+/*
+ * Appends a block of rows given column by column (cols[c] holds the new values of attribute c), moving the
+ * vectors into the relation when it is empty. All columns must have the same length; otherwise
+ * std::invalid_argument is thrown and the relation is left unchanged.
+ */
+void relation::appendColumns(vector<trackedVector<int>>&& cols) {
+    this->makeWritable();
+
+    if (cols.size() != this->getColumnCount()) {
+        throw std::invalid_argument("Expected " + to_string(this->getColumnCount()) + " columns!");
+    }
+
+    int added = cols.empty() ? 0 : cols[0].size();
+    for (const trackedVector<int>& col : cols) {
+        if (col.size() != added) {
+            throw std::invalid_argument("Appended columns differ in length!");
+        }
+    }
+
+    vector<columnStats>* stats = this->getMaintainedStatistics();
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        if (this->rowCount == 0) {
+            this->columns[c] = make_shared<trackedVector<int>>(move(cols[c]));
+        } else {
+            this->columns[c]->insert(this->columns[c]->end(), cols[c].begin(), cols[c].end());
+        }
+
+        if (stats != nullptr) {
+            for (int i = this->rowCount; i < this->rowCount + added; i++) {
+                (*stats)[c].add((*this->columns[c])[i]);
+            }
+        }
+    }
+
+    this->rowCount += added;
+    this->sortedIndexes.clear();
+    if (stats == nullptr) {
+        this->stats.reset();
+    }
+}
+
+/*
+ * Rows are not stored contiguously, so the tuple is gathered from the columns and returned by value.
+ */
+vector<int> relation::getTuple(unsigned int idx) const {
     if (idx < this->getRowCount() && idx >= 0) {
-        return this->data.at(idx);
+        vector<int> tup(this->getColumnCount());
+        const int* ids = this->getRowIds();
+
+        for (int c = 0; c < this->getColumnCount(); c++) {
+            tup[c] = this->getBaseColumn(c)[ids == nullptr ? idx : ids[idx]];
+        }
+
+        return tup;
     } else {
         throw std::out_of_range("Index out of range!");
     }
 }
 
+/*
+ * Returns a contiguous view of column col. For a row-selection view the selected values are gathered into
+ * new storage on the first call and kept for later calls; like index building, this is not synchronized.
+ */
+columnSpan relation::getColumn(int col) const {
+    if (col < 0 || col >= this->getColumnCount()) {
+        throw std::out_of_range("Column index out of range!");
+    }
+    if (!this->selection) {
+        return this->getBaseColumn(col);
+    }
+
+    this->gathered.resize(this->getColumnCount());
+    if (!this->gathered[col]) {
+        columnSpan base = this->getBaseColumn(col);
+        const int* ids = this->getRowIds();
+        shared_ptr<trackedVector<int>> vals = make_shared<trackedVector<int>>(this->rowCount);
+
+        for (int r = 0; r < this->rowCount; r++) {
+            (*vals)[r] = base[ids[r]];
+        }
+        this->gathered[col] = vals;
+    }
+    return columnSpan{this->gathered[col]->data(), this->rowCount};
+}
+
+/*
+ * Views share the storage of the relation they were taken from and cost O(1) (slice, selectColumns) or
+ * O(selected rows) (selectRows, semiJoin, antiJoin) to create. A view is read like any other relation;
+ * modifying one first copies the rows it sees into storage of its own.
+ */
+bool relation::isView() const {
+    return this->selection || this->rowOffset != 0 || (!this->mapping && !this->columns.empty()
+                                                         && this->columns[0]->size() != this->rowCount);
+}
+
+/*
+ * Returns the view of rows [first, first + count).
+ */
+relation relation::slice(int first, int count) const {
+    if (first < 0 || count < 0 || first > this->rowCount - count) {
+        throw std::out_of_range("Slice out of range!");
+    }
+
+    relation res = this->shareStorage();
+    res.rowOffset = this->rowOffset + first;
+    res.rowCount = count;
+    return res;
+}
+
+/*
+ * Returns the view of the given rows of "this" relation, in the given order; rows may repeat. Throws
+ * std::out_of_range if a row is not in [0, getRowCount()).
+ */
+relation relation::selectRows(const vector<int>& rows) const {
+    return this->selectRows(rows.data(), rows.size());
+}
+
+/*
+ * selectRows over the count row numbers at rows, so operators can pass their tracked selection buffers.
+ */
+relation relation::selectRows(const int* rows, int count) const {
+    relation res = this->shareStorage();
+    const int* ids = this->getRowIds();
+    shared_ptr<trackedVector<int>> selected = make_shared<trackedVector<int>>(count);
+
+    for (int i = 0; i < count; i++) {
+        if (rows[i] < 0 || rows[i] >= this->rowCount) {
+            throw std::out_of_range("Row " + to_string(rows[i]) + " out of range!");
+        }
+        (*selected)[i] = ids == nullptr ? this->rowOffset + rows[i] : ids[rows[i]];
+    }
+
+    res.selection = selected;
+    res.rowOffset = 0;
+    res.rowCount = count;
+    res.gathered.clear();
+    return res;
+}
+
+/*
+ * Returns the view of the given attributes, in the given order, keeping duplicate tuples (unlike project).
+ * Unknown and repeated attributes are skipped.
+ */
+relation relation::selectColumns(vector<string>& attrs) const {
+    relation res = this->shareStorage();
+    res.attributes.clear();
+    res.columns.clear();
+    res.mappedColumns.clear();
+    res.gathered.clear();
+
+    for (const string& attr : attrs) {
+        int col = this->getColumnIndex(attr);
+
+        if (col != -1 && res.attributes.count(attr) == 0) {
+            res.attributes.emplace(attr, res.attributes.size());
+            if (this->mapping) {
+                res.mappedColumns.push_back(this->mappedColumns[col]);
+            } else {
+                res.columns.push_back(this->columns[col]);
+            }
+            res.gathered.push_back(col < this->gathered.size() ? this->gathered[col] : nullptr);
+        }
+    }
+
+    return res;
+}
+
+relation relation::select(const predicate& pred) const {
+    return this->select(vector<predicate>{pred});
+}
+
+/*
+ * Returns the view of the tuples of "this" relation satisfying every predicate, in their original order.
+ * The predicates are evaluated one after another, each on the rows that passed the previous ones only.
+ */
+relation relation::select(const vector<predicate>& preds) const {
+    if (preds.empty()) {
+        return *this;
+    }
+
+    profileScope scope("select");
+    scope.addInput(*this);
+    const int* ids = this->getRowIds();
+    trackedVector<int> rows(this->rowCount);
+    int count = this->rowCount;
+
+    for (int p = 0; p < preds.size(); p++) {
+        int col = this->getColumnIndex(preds[p].getAttribute());
+        if (col == -1) {
+            throw std::out_of_range("Unknown attribute " + preds[p].getAttribute() + "!");
+        }
+        // the selection vector holds physical row ids of a row-selection view, logical rows otherwise
+        count = preds[p].select(this->getBaseColumn(col), p == 0 ? ids : rows.data(), count, rows.data());
+    }
+
+    rows.resize(count);
+    relation res;
+    if (ids == nullptr) {
+        res = this->selectRows(rows.data(), rows.size());
+    } else {
+        res = this->shareStorage();
+        res.selection = make_shared<trackedVector<int>>(rows.begin(), rows.end());
+        res.rowOffset = 0;
+        res.rowCount = count;
+        res.gathered.clear();
+    }
+
+    scope.setProbes(this->rowCount, count);
+    scope.setOutput(res);
+    return res;
+}
+
+/*
+ * Two relations are equal if they have the same attributes in the same column order and the same tuples in
+ * the same row order.
+ */
+bool relation::operator==(const relation& other) const {
+    if (this->getAttributes() != other.getAttributes() || this->rowCount != other.rowCount) {
+        return false;
+    }
+
+    for (int c = 0; c < this->getColumnCount(); c++) {
+        columnSpan thisCol = this->getColumn(c), otherCol = other.getColumn(c);
+
+        if (!equal(thisCol.begin(), thisCol.end(), otherCol.begin())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * A relation opened from a file (see relationFile) reads its columns straight from the file mapping and
+ * cannot be modified; derived relations (joins, projections, ...) are ordinary in-memory relations.
+ */
+bool relation::isReadOnly() const {
+    return this->mapping != nullptr;
+}
+
+/*
+ * Returns the row ids of the relation ordered by the value of attr (ties in row order). The index is built
+ * on first use and kept until the next insertTuple. Throws std::out_of_range for an unknown attribute.
+ * Index building is not synchronized, so it must not race with other calls on the same relation.
+ */
+const trackedVector<int>& relation::getSortedIndex(const string& attr) const {
+    int col = this->getColumnIndex(attr);
+
+    if (col == -1) {
+        throw std::out_of_range("Unknown attribute " + attr + "!");
+    }
+    return this->getSortedIndex(vector<int>{col});
+}
+
+bool relation::hasSortedIndex(const string& attr) const {
+    int col = this->getColumnIndex(attr);
+    return col != -1 && this->sortedIndexes.count(vector<int>{col}) != 0;
+}
+
+/*
+ * Returns the statistics of attr (see columnStats). Unless maintainStatistics(false) was called, they are kept
+ * up to date by insertTuple and appendColumns from the first row on. Otherwise, and for operator results, which
+ * are built without maintenance, they are computed by one scan on first use and kept until the relation changes.
+ * Throws std::out_of_range for an unknown attribute.
+ */
+const columnStats& relation::getColumnStats(const string& attr) const {
+    int col = this->getColumnIndex(attr);
+
+    if (col == -1) {
+        throw std::out_of_range("Unknown attribute " + attr + "!");
+    }
+
+    if (!this->stats) {
+        shared_ptr<vector<columnStats>> stats = make_shared<vector<columnStats>>(this->getColumnCount());
+
+        for (int c = 0; c < this->getColumnCount(); c++) {
+            for (int val : this->getColumn(c)) {
+                (*stats)[c].add(val);
+            }
+        }
+        this->stats = stats;
+    }
+
+    return (*this->stats)[col];
+}
+
+/*
+ * Whether the statistics of every attribute are updated on each insertTuple and appendColumns (the default) or
+ * discarded and recomputed by a full scan on the next getColumnStats. Maintenance costs a few hashes per
+ * inserted value; turning it off pays off for relations whose statistics are rarely read, such as operator
+ * results.
+ */
+void relation::maintainStatistics(bool maintain) {
+    this->statsMaintained = maintain;
+}
+
+/*
+ * Estimates the size of naturalJoin(other) from the column statistics of both relations.
+ * On the first shared attribute, the frequent values reported by either side are matched using their
+ * frequency estimates, and the remaining rows are assumed uniform over the remaining distinct values
+ * (|R| |S| / max(V(R,a), V(S,a))). Further shared attributes are treated as independent.
+ */
+double relation::estimateJoinSize(const relation& other) const {
+    double estimate = -1;
+
+    for (const string& attr : this->getAttributes()) {
+        if (other.getColumnIndex(attr) == -1) {
+            continue;
+        }
+
+        const columnStats& thisStats = this->getColumnStats(attr);
+        const columnStats& otherStats = other.getColumnStats(attr);
+
+        if (estimate >= 0) {
+            estimate /= max(1.0, max(thisStats.estimateDistinct(), otherStats.estimateDistinct()));
+            continue;
+        }
+
+        unordered_set<int> heavy;
+        for (const pair<int, long long>& hitter : thisStats.getHeavyHitters()) {
+            heavy.insert(hitter.first);
+        }
+        for (const pair<int, long long>& hitter : otherStats.getHeavyHitters()) {
+            heavy.insert(hitter.first);
+        }
+
+        double heavyJoin = 0, thisHeavy = 0, otherHeavy = 0;
+        for (int val : heavy) {
+            double thisFreq = thisStats.estimateFrequency(val), otherFreq = otherStats.estimateFrequency(val);
+            heavyJoin += thisFreq * otherFreq;
+            thisHeavy += thisFreq;
+            otherHeavy += otherFreq;
+        }
+
+        double thisRest = max(0.0, this->getRowCount() - thisHeavy);
+        double otherRest = max(0.0, other.getRowCount() - otherHeavy);
+        double distinct = max(thisStats.estimateDistinct(), otherStats.estimateDistinct()) - heavy.size();
+        estimate = heavyJoin + thisRest * otherRest / max(1.0, distinct);
+    }
+
+    return max(0.0, estimate);
+}
+
+void relation::reserve(int rows) {
+    this->makeWritable();
+
+    for (shared_ptr<trackedVector<int>>& col : this->columns) {
+        col->reserve(rows);
+    }
+}
+
 relation relation::project(const string& attr) const {
+    profileScope scope("project");
+    scope.addInput(*this);
     relation res;
     int colIdx = this->getColumnIndex(attr);
     int rowCount = this->getRowCount();
 
     if (colIdx != -1) {
+        auto index = this->sortedIndexes.find(vector<int>{colIdx});
+        if (index != this->sortedIndexes.end()) {
+            relation sorted = this->projectSorted(vector<int>{colIdx}, *index->second);
+            scope.setOutput(sorted);
+            return sorted;
+        }
+
+        columnSpan col = this->getColumn(colIdx);
         unordered_set<int> seenVals;
         res.addAttribute(attr);
 
         for (int i = 0; i < rowCount; i++) {
-            int val = this->data[i][colIdx];
-            if (seenVals.count(val) == 0) {
-                seenVals.insert(val);
-                vector<int> tup{val};
-                res.insertTuple(tup);
+            int val = col[i];
+            if (seenVals.insert(val).second) {
+                res.columns[0]->push_back(val);
+                res.rowCount++;
             }
         }
     }
 
+    scope.setOutput(res);
     return res;
 }
 
 relation relation::project(vector<string>& attrs) const {
+    profileScope scope("project");
+    scope.addInput(*this);
     relation res;
     vector<string> validAttrs;
+    vector<columnSpan> cols;
     vector<int> colIdxs;
 
     for (string attr : attrs) {
@@ -166,28 +577,38 @@ relation relation::project(vector<string>& attrs) const {
 
         if (idx != -1) {
             validAttrs.push_back(attr);
+            cols.push_back(this->getColumn(idx));
             colIdxs.push_back(idx);
         }
     }
 
+    auto index = this->sortedIndexes.find(colIdxs);
+    if (!validAttrs.empty() && index != this->sortedIndexes.end()) {
+        relation sorted = this->projectSorted(colIdxs, *index->second);
+        scope.setOutput(sorted);
+        return sorted;
+    }
+
     if (!validAttrs.empty()) {
         unordered_set<vector<int>, relation::hashFunction> seenVals;
+        vector<int> tup(cols.size());
         res.addAttributes(validAttrs);
 
         for (int i = 0; i < this->getRowCount(); i++) {
-            vector<int> tup;
-
-            for (int idx : colIdxs) {
-                tup.push_back(this->data[i][idx]);
+            for (int c = 0; c < cols.size(); c++) {
+                tup[c] = cols[c][i];
             }
 
-            if (seenVals.count(tup) == 0) {
-                seenVals.insert(tup);
-                res.insertTuple(tup);
+            if (seenVals.insert(tup).second) {
+                for (int c = 0; c < cols.size(); c++) {
+                    res.columns[c]->push_back(tup[c]);
+                }
+                res.rowCount++;
             }
         }
     }
 
+    scope.setOutput(res);
     return res;
 }
 
@@ -231,7 +652,16 @@ relation& relation::operator=(const relation& other) {
     if (this != &other) {
         this->name = other.name;
         this->attributes = other.attributes;
-        this->data = other.data;
+        this->columns = other.columns;
+        this->rowCount = other.rowCount;
+        this->selection = other.selection;
+        this->rowOffset = other.rowOffset;
+        this->gathered = other.gathered;
+        this->sortedIndexes = other.sortedIndexes;
+        this->stats = other.stats;
+        this->statsMaintained = other.statsMaintained;
+        this->mapping = other.mapping;
+        this->mappedColumns = other.mappedColumns;
     }
     return *this; // Return a reference to the current object
 }
@@ -247,52 +677,302 @@ std::ostream& operator<<(std::ostream& os, relation const& r)
 
 /*
  * Returns the result of a Full join between "this" relation and other relation (passed as argument)
- * The key to implementation is the creation of the hash map H on the first shared attributes between the two
- * relations. Values of the key attribute are mapped onto tuples the value occurs in within the second relation (other).
- * Once the hashmap is created, we iterate through the tuples of "this" relation and check if any tuples in the other
- * relation contain the current value for the keyed attribute using the hashmap. If this check returns tuples in the
- * other relation, we then check that the values for all other shared attributes are equivalent between the current
- * tuple in "this" relation and the tuple in the other relation. If this is true, then we can add the new merged tuple
- * to the resultant full join relation.
+ * The key to implementation is the creation of the hash table H (see joinHashTable) on all shared attributes
+ * between the two relations. Composite values of the shared attributes are mapped onto tuples the value occurs in
+ * within the second relation (other). Once the hash table is created, we iterate through the tuples of "this"
+ * relation and look up the tuples in the other relation holding the same values for every shared attribute.
+ * Each of those is a true match, so the merged tuple is added to the resultant full join relation directly.
+ * Column indexes of the shared attributes and the source column of every output attribute are resolved once
+ * before the probe loop, and output columns are filled directly from the input columns.
  */
 relation relation::naturalJoin(const relation& other) const{
+    return this->naturalJoin(other, 1);
+}
+
+/*
+ * Same as naturalJoin(other), executed on up to threadCount threads when threadCount is greater than one.
+ * Both relations are radix-partitioned on the hash of the shared attributes so that the hash table of every
+ * partition fits in cache. Partitions are then built and probed concurrently, each thread appending to its
+ * own output buffers, and the buffers are concatenated at the end. The result holds the same tuples as the
+ * single-threaded join, possibly in a different order.
+ */
+relation relation::naturalJoin(const relation& other, unsigned int threadCount) const{
+    profileScope scope("naturalJoin");
+    scope.addInput(*this);
+    scope.addInput(other);
     vector<string> attr1 = this->getAttributes();
     vector<string> attr2 = other.getAttributes();
-    unordered_set<string> sharedAttr = getIntersection(attr1, attr2);
+    vector<columnSpan> thisKeyCols, otherKeyCols;
+    this->getSharedColumns(other, thisKeyCols, otherKeyCols);
     relation res;
 
-    if (!sharedAttr.empty()) {
+    if (!thisKeyCols.empty()) {
         vector<string> unionAttr = attr1;
         for (string attr : attr2) {
-            if (sharedAttr.count(attr) == 0) {
+            if (this->getColumnIndex(attr) == -1) {
                 unionAttr.push_back(attr);
             }
         }
         res.addAttributes(unionAttr);
 
-        string keyAttr = *sharedAttr.begin();
-        unordered_map<int, vector<int>> valMap = other.buildMapForAttr(keyAttr);
-        int thisKeyCol = this->getColumnIndex(keyAttr);
+        // output column c is copied from srcCols[c], which belongs to "this" relation if fromThis[c] is set
+        vector<columnSpan> srcCols;
+        vector<bool> fromThis;
+        for (string attr : unionAttr) {
+            int thisCol = this->getColumnIndex(attr);
+            fromThis.push_back(thisCol != -1);
+            if (thisCol != -1) {
+                srcCols.push_back(this->getColumn(thisCol));
+            } else {
+                srcCols.push_back(other.getColumn(other.getColumnIndex(attr)));
+            }
+        }
 
-        for (int i = 0; i < this->getRowCount(); i++) {
-            int thisKeyVal = this->data[i][thisKeyCol];
-            if (valMap.count(thisKeyVal) != 0) {
-                for (int idx : valMap[thisKeyVal]) {
-                    if (this->areRowsJoinable(i, idx, other, sharedAttr)) {
-                        vector<int> mergedTup = this->mergeRows(i, idx, other, unionAttr);
-                        res.insertTuple(mergedTup);
+        int colCount = unionAttr.size();
+
+        if (threadCount <= 1) {
+            joinHashTable table(otherKeyCols);
+            int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+
+            for (int start = 0; start < this->getRowCount(); start += joinHashTable::batchSize) {
+                int n = min(joinHashTable::batchSize, this->getRowCount() - start);
+                for (int b = 0; b < n; b++) {
+                    rows[b] = start + b;
+                }
+                table.findGroups(thisKeyCols, rows, n, groups);
+
+                for (int b = 0; b < n; b++) {
+                    if (groups[b] == -1) {
+                        continue;
+                    }
+                    for (int idx : table.getGroup(groups[b])) {
+                        for (int c = 0; c < colCount; c++) {
+                            res.columns[c]->push_back(srcCols[c][fromThis[c] ? rows[b] : idx]);
+                        }
+                        res.rowCount++;
+                    }
+                }
+            }
+
+            scope.setBuild(other.getRowCount());
+            scope.setProbes(this->getRowCount(), res.getRowCount());
+            scope.setOutput(res);
+            return res;
+        }
+
+        // aim for about 16K build rows per partition, with enough partitions to balance the threads
+        int bits = 0;
+        while (bits < 12 && ((1 << bits) < 4 * (int)threadCount || (other.getRowCount() >> bits) > (1 << 14))) {
+            bits++;
+        }
+
+        vector<int> thisOffsets, otherOffsets;
+        vector<int> thisRows = joinHashTable::partitionRows(thisKeyCols, bits, threadCount, thisOffsets);
+        vector<int> otherRows = joinHashTable::partitionRows(otherKeyCols, bits, threadCount, otherOffsets);
+        vector<vector<trackedVector<int>>> buffers(threadCount, vector<trackedVector<int>>(colCount));
+
+        parallelFor(1 << bits, threadCount, [&](int p, int worker) {
+            int buildCount = otherOffsets[p + 1] - otherOffsets[p];
+            if (buildCount == 0) {
+                return;
+            }
+
+            joinHashTable table(otherKeyCols, otherRows.data() + otherOffsets[p], buildCount);
+            vector<trackedVector<int>>& out = buffers[worker];
+            int groups[joinHashTable::batchSize];
+
+            for (int start = thisOffsets[p]; start < thisOffsets[p + 1]; start += joinHashTable::batchSize) {
+                int n = min(joinHashTable::batchSize, thisOffsets[p + 1] - start);
+                const int* rows = thisRows.data() + start;
+                table.findGroups(thisKeyCols, rows, n, groups);
+
+                for (int b = 0; b < n; b++) {
+                    if (groups[b] == -1) {
+                        continue;
+                    }
+                    for (int idx : table.getGroup(groups[b])) {
+                        for (int c = 0; c < colCount; c++) {
+                            out[c].push_back(srcCols[c][fromThis[c] ? rows[b] : idx]);
+                        }
+                    }
+                }
+            }
+        });
+
+        for (const vector<trackedVector<int>>& out : buffers) {
+            res.rowCount += out[0].size();
+        }
+        parallelFor(colCount, threadCount, [&](int c, int) {
+            res.columns[c]->reserve(res.rowCount);
+            for (vector<trackedVector<int>>& out : buffers) {
+                res.columns[c]->insert(res.columns[c]->end(), out[c].begin(), out[c].end());
+                trackedVector<int>().swap(out[c]);
+            }
+        });
+
+        scope.setBuild(other.getRowCount());
+        scope.setProbes(this->getRowCount(), res.getRowCount());
+    }
+
+    scope.setOutput(res);
+    return res;
+}
+
+/*
+ * Returns the same result as naturalJoin(other), computed by merging the sorted indexes of both relations on
+ * their shared attributes (see getSortedIndex). Indexes are built once and reused by later calls, which suits
+ * relations joined repeatedly on the same attributes. The output is sorted on the shared attributes and keeps
+ * that order as a ready-made sorted index, so a following mergeJoin or project on those attributes runs as a
+ * linear scan.
+ */
+relation relation::mergeJoin(const relation& other) const {
+    profileScope scope("mergeJoin");
+    scope.addInput(*this);
+    scope.addInput(other);
+    vector<string> attr1 = this->getAttributes();
+    vector<int> thisKeyIdxs, otherKeyIdxs;
+    relation res;
+
+    for (int c = 0; c < attr1.size(); c++) {
+        int otherCol = other.getColumnIndex(attr1[c]);
+        if (otherCol != -1) {
+            thisKeyIdxs.push_back(c);
+            otherKeyIdxs.push_back(otherCol);
+        }
+    }
+
+    if (thisKeyIdxs.empty()) {
+        return res;
+    }
+
+    vector<string> unionAttr = attr1;
+    for (string attr : other.getAttributes()) {
+        if (this->getColumnIndex(attr) == -1) {
+            unionAttr.push_back(attr);
+        }
+    }
+    res.addAttributes(unionAttr);
+
+    vector<columnSpan> srcCols;
+    vector<bool> fromThis;
+    for (string attr : unionAttr) {
+        int thisCol = this->getColumnIndex(attr);
+        fromThis.push_back(thisCol != -1);
+        srcCols.push_back(thisCol != -1 ? this->getColumn(thisCol) : other.getColumn(other.getColumnIndex(attr)));
+    }
+
+    vector<columnSpan> thisKeyCols, otherKeyCols;
+    for (int c = 0; c < thisKeyIdxs.size(); c++) {
+        thisKeyCols.push_back(this->getColumn(thisKeyIdxs[c]));
+        otherKeyCols.push_back(other.getColumn(otherKeyIdxs[c]));
+    }
+
+    const trackedVector<int>& thisIndex = this->getSortedIndex(thisKeyIdxs);
+    const trackedVector<int>& otherIndex = other.getSortedIndex(otherKeyIdxs);
+    int colCount = unionAttr.size();
+    int i = 0, j = 0;
+
+    while (i < thisIndex.size() && j < otherIndex.size()) {
+        int cmp = compareKeys(thisKeyCols, thisIndex[i], otherKeyCols, otherIndex[j]);
+
+        if (cmp < 0) {
+            i++;
+        } else if (cmp > 0) {
+            j++;
+        } else {
+            // emit the cross product of the two runs holding this key
+            int iEnd = i + 1, jEnd = j + 1;
+            while (iEnd < thisIndex.size() && compareKeys(thisKeyCols, thisIndex[iEnd], thisKeyCols, thisIndex[i]) == 0) {
+                iEnd++;
+            }
+            while (jEnd < otherIndex.size() && compareKeys(otherKeyCols, otherIndex[jEnd], otherKeyCols, otherIndex[j]) == 0) {
+                jEnd++;
+            }
+
+            for (int a = i; a < iEnd; a++) {
+                for (int b = j; b < jEnd; b++) {
+                    for (int c = 0; c < colCount; c++) {
+                        res.columns[c]->push_back(srcCols[c][fromThis[c] ? thisIndex[a] : otherIndex[b]]);
                     }
                 }
             }
+            res.rowCount += (iEnd - i) * (jEnd - j);
+            i = iEnd;
+            j = jEnd;
         }
     }
 
+    // the output holds the attributes of "this" relation at their original positions, followed by the extra
+    // attributes of other, so the rows sorted on thisKeyIdxs are indexed by those same column positions
+    trackedVector<int> identity(res.rowCount);
+    for (int r = 0; r < res.rowCount; r++) {
+        identity[r] = r;
+    }
+    res.sortedIndexes[thisKeyIdxs] = make_shared<const trackedVector<int>>(move(identity));
+
+    scope.setOutput(res);
     return res;
 }
 
+/*
+ * Returns the tuples of "this" relation that join with at least one tuple of other.
+ * Only the shared attributes of other are hashed (without row ids), and "this" relation is filtered against
+ * that key set in a single pass, so the join itself is never materialized. Tuples keep their order and
+ * multiplicity. If the relations share no attribute, every tuple qualifies as long as other is not empty.
+ */
 relation relation::semiJoin(const relation& other) const {
-    vector<string> attr = this->getAttributes();
-    return this->naturalJoin(other).project(attr);
+    return this->filterByKeys(other, true, 1);
+}
+
+/*
+ * Same as semiJoin(other), probing chunks of "this" relation on up to threadCount threads.
+ */
+relation relation::semiJoin(const relation& other, unsigned int threadCount) const {
+    return this->filterByKeys(other, true, threadCount);
+}
+
+/*
+ * Returns the tuples of "this" relation that join with no tuple of other (the complement of semiJoin).
+ */
+relation relation::antiJoin(const relation& other) const {
+    return this->filterByKeys(other, false, 1);
+}
+
+relation relation::antiJoin(const relation& other, unsigned int threadCount) const {
+    return this->filterByKeys(other, false, threadCount);
+}
+
+/*
+ * Returns a superset of semiJoin(other): the tuples of "this" relation whose key passes a Bloom filter of the
+ * keys of other, built with about bitsPerKey bits per tuple of other. Every joining tuple is kept; a dangling
+ * tuple survives only on a false positive of the filter.
+ */
+relation relation::approximateSemiJoin(const relation& other, int bitsPerKey) const {
+    profileScope scope("approximateSemiJoin");
+    scope.addInput(*this);
+    scope.addInput(other);
+    vector<columnSpan> thisKeyCols, otherKeyCols;
+    this->getSharedColumns(other, thisKeyCols, otherKeyCols, true);
+
+    if (thisKeyCols.empty()) {
+        return other.getRowCount() > 0 ? *this : this->slice(0, 0);
+    }
+
+    bloomFilter filter(otherKeyCols, other.getRowIds(), other.getRowCount(), bitsPerKey);
+    const int* ids = this->getRowIds();
+    trackedVector<int> selection;
+
+    for (int i = 0; i < this->getRowCount(); i++) {
+        if (filter.mayContain(thisKeyCols, ids == nullptr ? i : ids[i])) {
+            selection.push_back(i);
+        }
+    }
+
+    relation res = this->selectRows(selection.data(), selection.size());
+    scope.setBuild(other.getRowCount());
+    scope.setProbes(this->getRowCount(), selection.size());
+    scope.setOutput(res);
+    return res;
 }
 
 /*
@@ -304,38 +984,309 @@ relation relation::semiJoin(const relation& other) const {
  * of Yanankakis algorithm
  */
 relation relation::executeLineJoin(const vector<relation>& relations) {
+    profileScope scope("executeLineJoin");
     int k = relations.size();
     vector<relation> prunedRelations(k);
 
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
     if (k == 0) {
         return relation();
     } else if (k == 1) {
         return relations[0];
     }
 
-    // removes dangling tuples by performing a semi-join reduction sweep from the tail to the head
-    // of the line join and then another semi-join reduction sweep from the head to the tail.
-    prunedRelations[k-1] = relations[k-1];
-    for (int i = k-2; i >= 0; i--) {
-        relation r = relations[i].semiJoin(relations[i+1]);
-        prunedRelations[i] = r;
+    prunedRelations = reduceLine(relations);
+
+    // Join relations in post-order traversal (from tail to head)
+    {
+        profileScope joins("joins");
+        for (int i = k-2; i >= 0; i--) {
+            relation r = prunedRelations[i].naturalJoin(prunedRelations[i+1]);
+            prunedRelations[i] = r;
+        }
+    }
+
+    // the first relation will have the result of the line join query
+    scope.setOutput(prunedRelations[0]);
+    return prunedRelations[0];
+}
+
+/*
+ * Evaluates the line join query restricted to the tuples satisfying every predicate. Each predicate is pushed
+ * down to all relations holding its attribute (both neighbours for a join attribute) before the semi-join
+ * sweeps, so selective predicates shrink every step of the evaluation.
+ */
+relation relation::executeLineJoin(const vector<relation>& relations, const vector<predicate>& predicates) {
+    return executeLineJoin(pushDownSelections(relations, predicates));
+}
+
+/*
+ * Variant of executeLineJoin whose reduction phase uses Bloom filters instead of exact semi-joins.
+ * Both sweeps pass a filter of the join keys of the previous (reduced) relation along the chain, so dangling
+ * tuples are dropped at a cost of bitsPerKey bits per key and one cache line per probe. The few false positives
+ * that survive find no partner in the exact hash joins that follow, hence the result equals executeLineJoin.
+ */
+relation relation::executeLineJoinWithBloomFilters(const vector<relation>& relations, int bitsPerKey) {
+    profileScope scope("executeLineJoinWithBloomFilters");
+    int k = relations.size();
+    vector<relation> prunedRelations(relations);
+
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
+    if (k == 0) {
+        return relation();
+    }
+
+    {
+        profileScope backward("backward Bloom filters");
+        for (int i = k-2; i >= 0; i--) {
+            prunedRelations[i] = prunedRelations[i].approximateSemiJoin(prunedRelations[i+1], bitsPerKey);
+        }
     }
 
-    for (int i = 1; i < k; i++) {
-        relation r = prunedRelations[i].semiJoin(prunedRelations[i-1]);
-        prunedRelations[i] = r;
+    {
+        profileScope forward("forward Bloom filters");
+        for (int i = 1; i < k; i++) {
+            prunedRelations[i] = prunedRelations[i].approximateSemiJoin(prunedRelations[i-1], bitsPerKey);
+        }
+    }
+
+    {
+        profileScope joins("joins");
+        for (int i = k-2; i >= 0; i--) {
+            prunedRelations[i] = prunedRelations[i].naturalJoin(prunedRelations[i+1]);
+        }
+    }
+
+    scope.setOutput(prunedRelations[0]);
+    return prunedRelations[0];
+}
+
+/*
+ * Variant of executeLineJoin returning the result in factorized form: the reduced relations plus hash indexes,
+ * in O(N) space instead of O(OUT). See factorizedResult for counting, enumeration and random access.
+ */
+factorizedResult relation::executeLineJoinFactorized(const vector<relation>& relations) {
+    return factorizedResult(relations);
+}
+
+/*
+ * Pipelined version of executeLineJoin. After the semi-join reduction, a hash index is built once per relation
+ * on its attributes shared with the previous relation (see factorizedResult). Result tuples are then
+ * enumerated depth-first through the chain of probes and handed to sink as soon as they are formed.
+ * No intermediate or final relation is materialized, so memory use is bounded by the size of the input
+ * and results of any size can be consumed. The tuple passed to sink is ordered as
+ * getLineJoinAttributes(relations), and the number of emitted tuples is returned.
+ */
+long long relation::streamLineJoin(const vector<relation>& relations, const tupleSink& sink) {
+    factorizedResult res(relations);
+    factorizedResult::enumerator e = res.enumerate();
+    long long count = 0;
+
+    while (e.next()) {
+        sink(e.getTuple());
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Returns the attributes of the result of a line join over relations, in the order produced by
+ * executeLineJoinByChaining: the attributes of R1 followed by the new attributes of every later relation.
+ */
+vector<string> relation::getLineJoinAttributes(const vector<relation>& relations) {
+    vector<string> attrs;
+    unordered_set<string> seen;
+
+    for (const relation& r : relations) {
+        for (const string& attr : r.getAttributes()) {
+            if (seen.insert(attr).second) {
+                attrs.push_back(attr);
+            }
+        }
+    }
+
+    return attrs;
+}
+
+/*
+ * Parallel version of executeLineJoin running on up to threadCount threads.
+ * On a line, a tuple of Ri survives the full semi-join reduction iff it joins with the backward-reduced Ri+1
+ * and with the forward-reduced Ri-1. The backward sweep (Bi = Ri semi-join Bi+1) and the forward sweep
+ * (Fi = Ri semi-join Fi-1) therefore run concurrently, each on half of the threads. The fully reduced
+ * relations Bi semi-join Fi-1 are then independent of each other and computed all at once. Every semi-join
+ * and every final join is itself data-parallel. The result holds the same tuples as executeLineJoin.
+ */
+relation relation::executeLineJoinParallel(const vector<relation>& relations, unsigned int threadCount) {
+    int k = relations.size();
+
+    if (threadCount <= 1 || k <= 1) {
+        return executeLineJoin(relations);
     }
 
+    profileScope scope("executeLineJoinParallel");
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
+    vector<relation> backward(k), forward(k);
+    unsigned int sweepThreads = max(1U, threadCount / 2);
+
+    // only the sweep run by the calling thread is recorded in its profile
+    parallelFor(2, 2, [&](int sweep, int) {
+        if (sweep == 0) {
+            backward[k-1] = relations[k-1];
+            for (int i = k-2; i >= 0; i--) {
+                backward[i] = relations[i].semiJoin(backward[i+1], sweepThreads);
+            }
+        } else {
+            forward[0] = relations[0];
+            for (int i = 1; i < k; i++) {
+                forward[i] = relations[i].semiJoin(forward[i-1], sweepThreads);
+            }
+        }
+    });
+
+    vector<relation> prunedRelations(k);
+    unsigned int stepThreads = max(1U, threadCount / (k-1));
+    prunedRelations[0] = backward[0];
+
+    parallelFor(k-1, threadCount, [&](int step, int) {
+        int i = step + 1;
+        prunedRelations[i] = backward[i].semiJoin(forward[i-1], stepThreads);
+    });
+
     // Join relations in post-order traversal (from tail to head)
     for (int i = k-2; i >= 0; i--) {
-        relation r = prunedRelations[i].naturalJoin(prunedRelations[i+1]);
-        prunedRelations[i] = r;
+        prunedRelations[i] = prunedRelations[i].naturalJoin(prunedRelations[i+1], threadCount);
     }
 
-    // the first relation will have the result of the line join query
+    scope.setOutput(prunedRelations[0]);
     return prunedRelations[0];
 }
 
+/*
+ * Evaluates the line join query of the form
+ * q(A1, ... , Ak+1) :- R1(A1, A2), R2(A2, A3), ..., Rk(Ak, Ak+1)
+ * Input is assumed to be k binary relations in order of line join query.
+ * This algorithm computes the join by natural joins in the order chosen by the cost-based planner
+ * (see joinPlanner), which may be bushy, e.g. (R1 join R2) join (R3 join R4). If chosenPlan is not null,
+ * the planner is stored in it for inspection.
+ */
+relation relation::executeLineJoinByPlanning(const vector<relation>& relations, joinPlanner* chosenPlan) {
+    profileScope scope("executeLineJoinByPlanning");
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
+    joinPlanner planner;
+    {
+        profileScope planning("planning");
+        planner = joinPlanner(relations);
+    }
+    relation res;
+    try {
+        res = planner.execute(relations);
+    } catch (const memoryLimitExceeded&) {
+        if (!memoryTracker::fallbackAllowed()) {
+            throw;
+        }
+        res = executeLineJoin(relations);
+    }
+    scope.setOutput(res);
+
+    if (chosenPlan != nullptr) {
+        *chosenPlan = planner;
+    }
+
+    return res;
+}
+
+/*
+ * Evaluates the natural join of an arbitrary alpha-acyclic set of relations (lines, stars, snowflakes, ...)
+ * with the full Yannakakis algorithm over the join tree found by the GYO reduction (see joinTree):
+ *   1. a bottom-up semi-join pass reduces every parent by its children,
+ *   2. a top-down semi-join pass reduces every child by its parent, leaving no dangling tuples,
+ *   3. relations are joined with their children's subtree results in post-order.
+ * Runs in O(N + OUT). The result holds the attributes of the root first, then those of its subtrees.
+ * Throws std::invalid_argument if the query is cyclic or not connected.
+ */
+relation relation::executeAcyclicJoin(const vector<relation>& relations) {
+    int k = relations.size();
+
+    if (k == 0) {
+        return relation();
+    } else if (k == 1) {
+        return relations[0];
+    }
+
+    profileScope scope("executeAcyclicJoin");
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
+    joinTree tree(relations);
+    if (!tree.isAcyclic()) {
+        throw std::invalid_argument("Query is cyclic!");
+    }
+    if (!tree.isConnected()) {
+        throw std::invalid_argument("Query is not connected!");
+    }
+
+    vector<int> order = tree.postOrder();
+    vector<relation> prunedRelations = relations;
+
+    for (int node : order) {
+        int parent = tree.getParent(node);
+        if (parent != -1) {
+            prunedRelations[parent] = prunedRelations[parent].semiJoin(prunedRelations[node]);
+        }
+    }
+
+    for (int i = k-1; i >= 0; i--) {
+        int parent = tree.getParent(order[i]);
+        if (parent != -1) {
+            prunedRelations[order[i]] = prunedRelations[order[i]].semiJoin(prunedRelations[parent]);
+        }
+    }
+
+    // children precede their parent in post-order, so their subtrees are joined by the time it is reached
+    for (int node : order) {
+        for (int child : tree.getChildren(node)) {
+            prunedRelations[node] = prunedRelations[node].naturalJoin(prunedRelations[child]);
+        }
+    }
+
+    scope.setOutput(prunedRelations[tree.getRoot()]);
+    return prunedRelations[tree.getRoot()];
+}
+
+/*
+ * Evaluates the natural join of an arbitrary set of relations, cyclic or not, with the worst-case optimal
+ * Leapfrog Triejoin (see leapfrogTriejoin), binding the attributes in order of first appearance.
+ * Meant for cyclic queries such as triangles, where no pairwise join plan avoids quadratic intermediates.
+ * Duplicate tuples in the inputs are not multiplied in the result.
+ */
+relation relation::executeWorstCaseOptimalJoin(const vector<relation>& relations) {
+    if (relations.empty()) {
+        return relation();
+    }
+    profileScope scope("executeWorstCaseOptimalJoin");
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
+    relation res = leapfrogTriejoin(relations).execute();
+    scope.setOutput(res);
+    return res;
+}
+
 /*
  * Evaluates the line join query of the form
  * q(A1, ... , Ak+1) :- R1(A1, A2), R2(A2, A3), ..., Rk(Ak, Ak+1)
@@ -346,86 +1297,350 @@ relation relation::executeLineJoin(const vector<relation>& relations) {
  * end it computes R1-k = R1-(k-1) join Rk.
  */
 relation relation::executeLineJoinByChaining(const vector<relation>& relations) {
+    profileScope scope("executeLineJoinByChaining");
     int k = relations.size();
     relation res;
 
+    for (const relation& r : relations) {
+        scope.addInput(r);
+    }
+
     if (k == 0) {
         return res;
     } else if (k == 1) {
         return relations[0];
     }
 
-    res = relations[0];
+    try {
+        res = relations[0];
 
-    for (int i = 1; i < k; i++) {
-        res = res.naturalJoin(relations[i]);
+        for (int i = 1; i < k; i++) {
+            res = res.naturalJoin(relations[i]);
+        }
+    } catch (const memoryLimitExceeded&) {
+        if (!memoryTracker::fallbackAllowed()) {
+            throw;
+        }
+        // intermediates may be far larger than the result; Yannakakis keeps them within the output size
+        res = relation();
+        res = executeLineJoin(relations);
     }
 
+    scope.setOutput(res);
     return res;
 }
 
+/*
+ * executeLineJoinByChaining with the predicates pushed down to the relations first (see executeLineJoin).
+ */
+relation relation::executeLineJoinByChaining(const vector<relation>& relations, const vector<predicate>& predicates) {
+    return executeLineJoinByChaining(pushDownSelections(relations, predicates));
+}
+
 /*
  * Private functions
  */
 
-unordered_map<int, vector<int>> relation::buildMapForAttr(const string& attr) const {
-    unordered_map<int, vector<int>> map;
-    int colIdx = this->getColumnIndex(attr);
+/*
+ * Removes dangling tuples from the relations of a line join query by performing a semi-join reduction sweep
+ * from the tail to the head of the line and then another semi-join reduction sweep from the head to the tail.
+ * Afterwards every remaining tuple takes part in at least one result tuple.
+ */
+vector<relation> relation::reduceLine(const vector<relation>& relations) {
+    int k = relations.size();
+    vector<relation> prunedRelations(k);
 
-    for (int i = 0; i < this->getRowCount(); i++) {
-        int val = this->data[i][colIdx];
+    if (k == 0) {
+        return prunedRelations;
+    }
 
-        if (map.count(val) == 0) {
-            vector<int> indexes;
-            indexes.push_back(i);
-            map[val] = indexes;
-        } else {
-            map[val].push_back(i);
+    {
+        profileScope backward("backward semi-joins");
+        prunedRelations[k-1] = relations[k-1];
+        for (int i = k-2; i >= 0; i--) {
+            prunedRelations[i] = relations[i].semiJoin(prunedRelations[i+1]);
         }
     }
 
-    return map;
+    {
+        profileScope forward("forward semi-joins");
+        for (int i = 1; i < k; i++) {
+            prunedRelations[i] = prunedRelations[i].semiJoin(prunedRelations[i-1]);
+        }
+    }
+
+    return prunedRelations;
 }
 
-bool relation::areRowsJoinable(int thisRow, int otherRow, const relation& other, unordered_set<string>& sharedAttr) const {
-    vector<int> thisTup = this->getTuple(thisRow);
-    vector<int> otherTup = other.getTuple(otherRow);
+/*
+ * Shared implementation of semiJoin (keepMatches set) and antiJoin (keepMatches unset).
+ * With several threads, "this" relation is probed in contiguous chunks whose selections are concatenated
+ * in chunk order, so the result is identical to the single-threaded one.
+ */
+relation relation::filterByKeys(const relation& other, bool keepMatches, unsigned int threadCount) const {
+    profileScope scope(keepMatches ? "semiJoin" : "antiJoin");
+    scope.addInput(*this);
+    scope.addInput(other);
+    vector<columnSpan> thisKeyCols, otherKeyCols;
+    this->getSharedColumns(other, thisKeyCols, otherKeyCols, true);
+    trackedVector<int> selection;
+
+    if (thisKeyCols.empty()) {
+        if ((other.getRowCount() > 0) == keepMatches) {
+            scope.setOutput(*this);
+            return *this;
+        }
+    } else {
+        // both sides are read in place through their row ids, so filtering a view gathers no columns
+        joinHashTable keys(otherKeyCols, other.getRowIds(), other.getRowCount(), false);
+        const int* ids = this->getRowIds();
+        int rowCount = this->getRowCount();
+        int chunkCount = max(1, (int)min<unsigned int>(threadCount, (rowCount + 4095) / 4096));
+        int chunkSize = (rowCount + chunkCount - 1) / chunkCount;
+        vector<trackedVector<int>> selections(chunkCount);
+
+        parallelFor(chunkCount, threadCount, [&](int chunk, int) {
+            int end = min(rowCount, (chunk + 1) * chunkSize);
+            int rows[joinHashTable::batchSize], groups[joinHashTable::batchSize];
+
+            for (int start = chunk * chunkSize; start < end; start += joinHashTable::batchSize) {
+                int n = min(joinHashTable::batchSize, end - start);
+                for (int b = 0; b < n; b++) {
+                    rows[b] = ids == nullptr ? start + b : ids[start + b];
+                }
+                keys.findGroups(thisKeyCols, rows, n, groups);
 
-    for (string attr : sharedAttr) {
-        int thisCol = this->getColumnIndex(attr);
-        int otherCol = other.getColumnIndex(attr);
+                for (int b = 0; b < n; b++) {
+                    if ((groups[b] != -1) == keepMatches) {
+                        selections[chunk].push_back(start + b);
+                    }
+                }
+            }
+        });
 
-        if (thisTup[thisCol] != otherTup[otherCol])
-            return false;
+        selection = move(selections[0]);
+        for (int chunk = 1; chunk < chunkCount; chunk++) {
+            selection.insert(selection.end(), selections[chunk].begin(), selections[chunk].end());
+        }
+
+        int matches = keepMatches ? selection.size() : rowCount - selection.size();
+        scope.setBuild(other.getRowCount());
+        scope.setProbes(rowCount, matches);
     }
 
-    return true;
+    relation res = this->selectRows(selection.data(), selection.size());
+    scope.setOutput(res);
+    return res;
 }
 
-vector<int> relation::mergeRows(int thisRow, int otherRow, const relation& other, const vector<string>& unionAttr) const {
-    vector<int> res;
+/*
+ * Applies every predicate to every relation holding its attribute. Throws std::out_of_range for a predicate
+ * on an attribute no relation holds.
+ */
+vector<relation> relation::pushDownSelections(const vector<relation>& relations, const vector<predicate>& predicates) {
+    profileScope scope("selections");
+    vector<relation> res;
+    vector<bool> used(predicates.size(), false);
+
+    for (const relation& r : relations) {
+        vector<predicate> preds;
+        for (int p = 0; p < predicates.size(); p++) {
+            if (r.getColumnIndex(predicates[p].getAttribute()) != -1) {
+                preds.push_back(predicates[p]);
+                used[p] = true;
+            }
+        }
+        res.push_back(preds.empty() ? r : r.select(preds));
+    }
 
-    for (string attr : unionAttr) {
-        int thisCol = this->getColumnIndex(attr);
+    for (int p = 0; p < predicates.size(); p++) {
+        if (!used[p]) {
+            throw std::out_of_range("Unknown attribute " + predicates[p].getAttribute() + "!");
+        }
+    }
+    return res;
+}
+
+/*
+ * Returns the row ids ordered lexicographically by the given columns, building and caching the index on first use.
+ */
+const trackedVector<int>& relation::getSortedIndex(const vector<int>& cols) const {
+    auto it = this->sortedIndexes.find(cols);
+    if (it != this->sortedIndexes.end()) {
+        return *it->second;
+    }
+
+    vector<columnSpan> keyCols;
+    for (int col : cols) {
+        keyCols.push_back(this->getColumn(col));
+    }
+
+    trackedVector<int> index(this->rowCount);
+    for (int r = 0; r < this->rowCount; r++) {
+        index[r] = r;
+    }
+    stable_sort(index.begin(), index.end(), [&keyCols](int a, int b) {
+        return compareKeys(keyCols, a, keyCols, b) < 0;
+    });
+
+    return *(this->sortedIndexes[cols] = make_shared<const trackedVector<int>>(move(index)));
+}
+
+/*
+ * Duplicate-free projection onto cols by one linear scan over a sorted index on exactly those columns.
+ * The result is sorted and records that as its own sorted index.
+ */
+relation relation::projectSorted(const vector<int>& cols, const trackedVector<int>& index) const {
+    vector<string> allAttrs = this->getAttributes(), attrs;
+    vector<columnSpan> keyCols;
+
+    for (int col : cols) {
+        attrs.push_back(allAttrs[col]);
+        keyCols.push_back(this->getColumn(col));
+    }
+
+    relation res(attrs);
+    for (int pos = 0; pos < index.size(); pos++) {
+        if (pos == 0 || compareKeys(keyCols, index[pos], keyCols, index[pos - 1]) != 0) {
+            for (int c = 0; c < cols.size(); c++) {
+                res.columns[c]->push_back(keyCols[c][index[pos]]);
+            }
+            res.rowCount++;
+        }
+    }
+
+    vector<int> resCols(cols.size());
+    trackedVector<int> identity(res.rowCount);
+    for (int c = 0; c < cols.size(); c++) {
+        resCols[c] = c;
+    }
+    for (int r = 0; r < res.rowCount; r++) {
+        identity[r] = r;
+    }
+    res.sortedIndexes[resCols] = make_shared<const trackedVector<int>>(move(identity));
+
+    return res;
+}
+
+/*
+ * Lexicographic comparison of the key of row a in colsA with the key of row b in colsB.
+ */
+int relation::compareKeys(const vector<columnSpan>& colsA, int a, const vector<columnSpan>& colsB, int b) {
+    for (int c = 0; c < colsA.size(); c++) {
+        if (colsA[c][a] != colsB[c][b]) {
+            return colsA[c][a] < colsB[c][b] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Collects the columns of the attributes shared by "this" relation and other, in the column order of
+ * "this" relation. thisCols[i] and otherCols[i] hold the same attribute. With physical set, the columns are
+ * the base columns of both relations, indexed by physical row ids (see getRowIds) instead of logical row numbers.
+ */
+void relation::getSharedColumns(const relation& other, vector<columnSpan>& thisCols, vector<columnSpan>& otherCols,
+                                bool physical) const {
+    for (const string& attr : this->getAttributes()) {
         int otherCol = other.getColumnIndex(attr);
 
-        if (thisCol != -1) {
-            res.push_back(this->data[thisRow][thisCol]);
-        } else {
-            res.push_back(other.data[otherRow][otherCol]);
+        if (otherCol != -1) {
+            int thisCol = this->getColumnIndex(attr);
+            thisCols.push_back(physical ? this->getBaseColumn(thisCol) : this->getColumn(thisCol));
+            otherCols.push_back(physical ? other.getBaseColumn(otherCol) : other.getColumn(otherCol));
         }
     }
+}
+
+/*
+ * Returns the storage column col reads from: the whole base column for a row-selection view (indexed
+ * through getRowIds), otherwise exactly the rows of this relation.
+ */
+columnSpan relation::getBaseColumn(int col) const {
+    columnSpan base = this->mapping ? this->mappedColumns[col]
+                                    : columnSpan{this->columns[col]->data(), (int)this->columns[col]->size()};
+
+    if (this->selection) {
+        return base;
+    }
+    return columnSpan{base.data + this->rowOffset, this->rowCount};
+}
+
+/*
+ * Returns the physical row id of every row of a row-selection view, or nullptr if row r is simply row r of
+ * getBaseColumn.
+ */
+const int* relation::getRowIds() const {
+    return this->selection ? this->selection->data() + this->rowOffset : nullptr;
+}
+
+/*
+ * Returns the statistics to update with the rows about to be inserted, or nullptr if they are not maintained.
+ * Maintenance of an empty relation starts here; statistics of a non-empty relation that were never computed
+ * are left to the scan of getColumnStats. Statistics shared with a copy are copied first.
+ */
+vector<columnStats>* relation::getMaintainedStatistics() {
+    if (!this->statsMaintained) {
+        return nullptr;
+    }
+
+    if (!this->stats && this->rowCount == 0) {
+        this->stats = make_shared<vector<columnStats>>(this->getColumnCount());
+    } else if (this->stats && this->stats.use_count() > 1) {
+        this->stats = make_shared<vector<columnStats>>(*this->stats);
+    }
+    return this->stats.get();
+}
 
+/*
+ * Returns a copy of "this" relation sharing its storage, without the lazily built per-relation state that
+ * does not carry over to a view.
+ */
+relation relation::shareStorage() const {
+    relation res(*this);
+    res.sortedIndexes.clear();
+    res.stats.reset();
+    res.statsMaintained = false;
     return res;
 }
 
-int relation::max_element(int col) const {
-    int maxVal = INT_MIN;
+void relation::checkWritable() const {
+    if (this->isReadOnly()) {
+        throw std::logic_error("Relation " + this->name + " is read-only!");
+    }
+}
 
-    for (int i = 0; i < this->getRowCount(); i++) {
-        maxVal = max(maxVal, this->data[i][col]);
+/*
+ * Prepares "this" relation for modification: a view, or a relation whose columns are shared with a copy,
+ * first moves the rows it sees into columns of its own. Cached indexes are always dropped.
+ */
+void relation::makeWritable() {
+    this->checkWritable();
+
+    bool shared = this->isView();
+    for (const shared_ptr<trackedVector<int>>& col : this->columns) {
+        shared = shared || col.use_count() > 1;
+    }
+
+    if (shared) {
+        vector<shared_ptr<trackedVector<int>>> own;
+
+        for (int c = 0; c < this->getColumnCount(); c++) {
+            columnSpan col = this->getColumn(c);
+            own.push_back(make_shared<trackedVector<int>>(col.begin(), col.end()));
+        }
+
+        this->columns = move(own);
+        this->selection.reset();
+        this->rowOffset = 0;
+        this->gathered.clear();
     }
+    this->sortedIndexes.clear();
+}
 
+int relation::max_element(int col) const {
+    int minVal, maxVal;
+    simdKernels::minMax(this->getColumn(col), minVal, maxVal);
     return maxVal;
 }
 
@@ -475,22 +1690,6 @@ string relation::rowToString(const vector<string>& row, const vector<int>& width
     return res;
 }
 
-unordered_set<string> relation::getIntersection(vector<string> v1, vector<string> v2) {
-    vector<string> intersect(min(v1.size(), v2.size()));
-    unordered_set<string> set;
-
-    set_intersection(v1.begin(), v1.end(),
-                     v2.begin(), v2.end(),
-                     intersect.begin());
-
-    for (string val : intersect) {
-        if (val != "")
-            set.insert(val);
-    }
-
-    return set;
-}
-
 int relation::sum(vector<int>& widths) {
     int sum = 0;
 
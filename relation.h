@@ -8,13 +8,29 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
+#include "columnSpan.h"
+#include "columnStats.h"
+#include "memoryTracker.h"
+#include "predicate.h"
 
 using namespace std;
 
+/*
+ * Consumer of result tuples for streaming operators. The tuple is only valid for the duration of the call.
+ */
+typedef function<void(const vector<int>&)> tupleSink;
+
+class factorizedResult;
+class joinPlanner;
+class relationFile;
+
 class relation {
     public:
         relation();
@@ -33,27 +49,76 @@ class relation {
         bool addAttributes(vector<string>& attrs);
         vector<vector<int>> getData() const;
         void insertTuple(vector<int>& tup);
-        const vector<int> & getTuple(unsigned int idx) const;
+        void appendColumns(vector<trackedVector<int>>&& cols);
+        vector<int> getTuple(unsigned int idx) const;
+        columnSpan getColumn(int col) const;
+        bool isReadOnly() const;
+        const trackedVector<int>& getSortedIndex(const string& attr) const;
+        bool hasSortedIndex(const string& attr) const;
+        const columnStats& getColumnStats(const string& attr) const;
+        void maintainStatistics(bool maintain);
+        double estimateJoinSize(const relation& other) const;
+        void reserve(int rows);
         relation project(const string& attr) const;
         relation project(vector<string>& attrs) const;
         string toString() const;
         relation& operator=(const relation& other);
         friend std::ostream& operator<<(std::ostream& os, relation const& r);
         relation naturalJoin(const relation& other) const;
+        relation naturalJoin(const relation& other, unsigned int threadCount) const;
+        relation mergeJoin(const relation& other) const;
         relation semiJoin(const relation& other) const;
+        relation semiJoin(const relation& other, unsigned int threadCount) const;
+        relation antiJoin(const relation& other) const;
+        relation antiJoin(const relation& other, unsigned int threadCount) const;
+        relation approximateSemiJoin(const relation& other, int bitsPerKey) const;
+        relation slice(int first, int count) const;
+        relation selectRows(const vector<int>& rows) const;
+        relation selectColumns(vector<string>& attrs) const;
+        relation select(const predicate& pred) const;
+        relation select(const vector<predicate>& preds) const;
+        bool isView() const;
+        bool operator==(const relation& other) const;
         static relation executeLineJoin(const vector<relation>& relations);
+        static relation executeLineJoin(const vector<relation>& relations, const vector<predicate>& predicates);
+        static relation executeLineJoinParallel(const vector<relation>& relations, unsigned int threadCount);
+        static relation executeLineJoinWithBloomFilters(const vector<relation>& relations, int bitsPerKey = 8);
+        static factorizedResult executeLineJoinFactorized(const vector<relation>& relations);
+        static long long streamLineJoin(const vector<relation>& relations, const tupleSink& sink);
+        static vector<string> getLineJoinAttributes(const vector<relation>& relations);
         static relation executeLineJoinByChaining(const vector<relation>& relations);
+        static relation executeLineJoinByChaining(const vector<relation>& relations,
+                                                  const vector<predicate>& predicates);
+        static relation executeLineJoinByPlanning(const vector<relation>& relations, joinPlanner* chosenPlan = nullptr);
+        static relation executeAcyclicJoin(const vector<relation>& relations);
+        static relation executeWorstCaseOptimalJoin(const vector<relation>& relations);
 
     private:
-        unordered_map<int, vector<int>> buildMapForAttr(const string& attr) const;
-        bool areRowsJoinable(int thisRow, int otherRow, const relation& other, unordered_set<string>& sharedAttr) const;
-        vector<int> mergeRows(int thisRow, int otherRow, const relation& other, const vector<string>& unionAttr) const;
+        friend class factorizedResult;
+        friend class lineJoinAggregate;
+        friend class relationFile;
+
+        static vector<relation> reduceLine(const vector<relation>& relations);
+        static vector<relation> pushDownSelections(const vector<relation>& relations,
+                                                   const vector<predicate>& predicates);
+        relation filterByKeys(const relation& other, bool keepMatches, unsigned int threadCount) const;
+        const trackedVector<int>& getSortedIndex(const vector<int>& cols) const;
+        relation projectSorted(const vector<int>& cols, const trackedVector<int>& index) const;
+        relation selectRows(const int* rows, int count) const;
+        void getSharedColumns(const relation& other, vector<columnSpan>& thisCols, vector<columnSpan>& otherCols,
+                              bool physical = false) const;
+        columnSpan getBaseColumn(int col) const;
+        const int* getRowIds() const;
+        relation shareStorage() const;
+        vector<columnStats>* getMaintainedStatistics();
+        void checkWritable() const;
+        void makeWritable();
         int max_element(int col) const;
 
         static string rowToString(const vector<int>& row, const vector<int>& widths);
         static string rowToString(const vector<string>& row, const vector<int>& widths);
-        static unordered_set<string> getIntersection(vector<string> v1, vector<string> v2);
         static int sum(vector<int>& widths);
+        static int compareKeys(const vector<columnSpan>& colsA, int a, const vector<columnSpan>& colsB, int b);
 
         /* private structs */
         // Hash function
@@ -75,7 +140,26 @@ class relation {
         /* properties */
         string name;
         map<string, int> attributes;
-        vector<vector<int>> data;
+        // columnar storage: (*columns[c])[r] is the value of attribute c in row r. Columns are shared between
+        // copies and views and copied by the first modification (see makeWritable)
+        vector<shared_ptr<trackedVector<int>>> columns;
+        int rowCount;
+        // a view reads rows rowOffset .. rowOffset + rowCount - 1 of its columns, or, given a selection,
+        // the rows (*selection)[rowOffset] .. (*selection)[rowOffset + rowCount - 1]
+        shared_ptr<const trackedVector<int>> selection;
+        int rowOffset;
+        // contiguous copies of the selected rows of a row-selection view, gathered on first use by getColumn
+        mutable vector<shared_ptr<const trackedVector<int>>> gathered;
+        // cached sorted permutations of the rows, keyed by the column indexes they are sorted on;
+        // cleared by insertTuple
+        mutable map<vector<int>, shared_ptr<const trackedVector<int>>> sortedIndexes;
+        // per-column statistics, updated on insert while statsMaintained is set (the default) and otherwise
+        // computed on demand and dropped on change; shared by copies until one of them inserts
+        mutable shared_ptr<vector<columnStats>> stats;
+        bool statsMaintained;
+        // a read-only relation keeps its columns in a shared file mapping; columns is then left empty
+        shared_ptr<const void> mapping;
+        vector<columnSpan> mappedColumns;
 };
 
 
@@ -0,0 +1,250 @@
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "relationFile.h"
+
+static const char magic[4] = {'R', 'E', 'L', 'F'};
+
+static bool isLittleEndian() {
+    unsigned int one = 1;
+    return *(unsigned char*)&one == 1;
+}
+
+static void putInt(string& buf, unsigned long long val, int bytes) {
+    for (int b = 0; b < bytes; b++) {
+        buf.push_back((char)(val >> (8 * b)));
+    }
+}
+
+static void putString(string& buf, const string& str) {
+    putInt(buf, str.size(), 4);
+    buf += str;
+}
+
+static unsigned long long alignUp(unsigned long long pos, unsigned long long alignment) {
+    return (pos + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * Bounds-checked little-endian reader over the mapped header.
+ */
+struct headerReader {
+    const unsigned char* data;
+    unsigned long long size;
+    unsigned long long pos;
+    const string& path;
+
+    unsigned long long get(int bytes) {
+        this->require(bytes);
+        unsigned long long val = 0;
+
+        for (int b = 0; b < bytes; b++) {
+            val |= (unsigned long long)this->data[this->pos++] << (8 * b);
+        }
+        return val;
+    }
+
+    string getString() {
+        unsigned long long len = this->get(4);
+        this->require(len);
+        string str((const char*)this->data + this->pos, len);
+        this->pos += len;
+        return str;
+    }
+
+    void require(unsigned long long bytes) const {
+        if (bytes > this->size - this->pos) {
+            throw std::runtime_error("Relation file " + this->path + " is truncated!");
+        }
+    }
+};
+
+/*
+ * Writes r to path in the format described in relationFile.h, replacing any existing file.
+ * With storeIndexes set, the sorted indexes r currently holds are stored along with the columns.
+ */
+void relationFile::write(const relation& r, const string& path, bool storeIndexes) {
+    int columnCount = r.getColumnCount();
+    unsigned long long rowCount = r.getRowCount();
+    vector<const trackedVector<int>*> indexes;
+    vector<vector<int>> indexCols;
+
+    if (storeIndexes) {
+        for (const auto& index : r.sortedIndexes) {
+            indexCols.push_back(index.first);
+            indexes.push_back(index.second.get());
+        }
+    }
+
+    string header(magic, sizeof(magic));
+    putInt(header, version, 4);
+    putInt(header, columnCount, 4);
+    putInt(header, indexes.size(), 4);
+    putInt(header, rowCount, 8);
+    putString(header, r.getName());
+    for (const string& attr : r.getAttributes()) {
+        putString(header, attr);
+    }
+
+    // the offsets follow all variable-length fields, so the header size is known before they are written
+    unsigned long long headerSize = header.size() + 8 * columnCount;
+    for (const vector<int>& cols : indexCols) {
+        headerSize += 4 + 4 * cols.size() + 8;
+    }
+
+    unsigned long long blockSize = alignUp(rowCount * sizeof(int), blockAlignment);
+    unsigned long long offset = alignUp(headerSize, blockAlignment);
+
+    for (int c = 0; c < columnCount; c++, offset += blockSize) {
+        putInt(header, offset, 8);
+    }
+    for (const vector<int>& cols : indexCols) {
+        putInt(header, cols.size(), 4);
+        for (int col : cols) {
+            putInt(header, col, 4);
+        }
+        putInt(header, offset, 8);
+        offset += blockSize;
+    }
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create relation file " + path + "!");
+    }
+
+    string block;
+    auto writeBlock = [&](const int* vals) {
+        if (blockSize == 0) {
+            return;
+        }
+
+        block.assign(blockSize, '\0');
+        if (isLittleEndian()) {
+            memcpy(&block[0], vals, rowCount * sizeof(int));
+        } else {
+            for (unsigned long long i = 0; i < rowCount; i++) {
+                for (int b = 0; b < 4; b++) {
+                    block[4 * i + b] = (char)((unsigned int)vals[i] >> (8 * b));
+                }
+            }
+        }
+        out.write(block.data(), block.size());
+    };
+
+    header.resize(alignUp(header.size(), blockAlignment), '\0');
+    out.write(header.data(), header.size());
+    for (int c = 0; c < columnCount; c++) {
+        writeBlock(r.getColumn(c).data);
+    }
+    for (const trackedVector<int>* index : indexes) {
+        writeBlock(index->data());
+    }
+
+    if (!out.flush()) {
+        throw std::runtime_error("Cannot write relation file " + path + "!");
+    }
+}
+
+/*
+ * Maps the relation file at path and returns it as a read-only relation whose columns point into the mapping.
+ * Pages are read lazily on first access and the mapping lives until the last relation sharing it is gone.
+ * Stored indexes are copied into the relation. Throws std::runtime_error if the file cannot be opened or is
+ * not a valid relation file.
+ */
+relation relationFile::open(const string& path) {
+    if (!isLittleEndian()) {
+        throw std::runtime_error("Relation files can only be mapped on little-endian hosts!");
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open relation file " + path + "!");
+    }
+
+    struct stat info;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Cannot map relation file " + path + "!");
+    }
+
+    unsigned long long size = info.st_size;
+    shared_ptr<const void> mapping(addr, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    headerReader in{(const unsigned char*)addr, size, 0, path};
+
+    in.require(sizeof(magic));
+    if (memcmp(addr, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not a relation file!");
+    }
+    in.pos += sizeof(magic);
+
+    unsigned long long fileVersion = in.get(4);
+    if (fileVersion != version) {
+        throw std::runtime_error("Unsupported relation file version " + to_string(fileVersion) + " in " + path + "!");
+    }
+
+    unsigned long long columnCount = in.get(4);
+    unsigned long long indexCount = in.get(4);
+    unsigned long long rowCount = in.get(8);
+    if (rowCount > INT_MAX) {
+        throw std::runtime_error("Relation file " + path + " has too many rows!");
+    }
+
+    // checks that a block of rowCount values at offset lies inside the file
+    auto blockAt = [&](unsigned long long offset) {
+        if (offset % sizeof(int) != 0 || offset > size || rowCount * sizeof(int) > size - offset) {
+            throw std::runtime_error("Relation file " + path + " is truncated!");
+        }
+        return columnSpan{(const int*)((const char*)addr + offset), (int)rowCount};
+    };
+
+    relation res(in.getString());
+    vector<string> attrs;
+    for (unsigned long long c = 0; c < columnCount; c++) {
+        attrs.push_back(in.getString());
+    }
+    if (!res.addAttributes(attrs)) {
+        throw std::runtime_error("Relation file " + path + " has duplicate attributes!");
+    }
+    res.columns.clear();
+    res.rowCount = rowCount;
+
+    for (unsigned long long c = 0; c < columnCount; c++) {
+        res.mappedColumns.push_back(blockAt(in.get(8)));
+    }
+
+    for (unsigned long long i = 0; i < indexCount; i++) {
+        unsigned long long keyCount = in.get(4);
+        if (keyCount == 0 || keyCount > columnCount) {
+            throw std::runtime_error("Relation file " + path + " has an invalid index!");
+        }
+
+        vector<int> cols(keyCount);
+        for (int& col : cols) {
+            col = in.get(4);
+            if (col < 0 || col >= columnCount) {
+                throw std::runtime_error("Relation file " + path + " has an index on an unknown column!");
+            }
+        }
+
+        columnSpan ids = blockAt(in.get(8));
+        for (int id : ids) {
+            if (id < 0 || id >= rowCount) {
+                throw std::runtime_error("Relation file " + path + " has an invalid index!");
+            }
+        }
+        res.sortedIndexes[cols] = make_shared<const trackedVector<int>>(ids.begin(), ids.end());
+    }
+
+    res.mapping = mapping;
+    return res;
+}
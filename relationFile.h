@@ -0,0 +1,33 @@
+#ifndef PROJECT_RELATIONFILE_H
+#define PROJECT_RELATIONFILE_H
+
+#include <string>
+#include "relation.h"
+
+using namespace std;
+
+/*
+ * Versioned binary file format for relations, opened through mmap without copying the data.
+ *
+ * Layout (all integers little-endian, version 1):
+ *   header   magic "RELF", u32 version, u32 column count, u32 index count, u64 row count,
+ *            name (u32 length + bytes), every attribute in column order (u32 length + bytes),
+ *            u64 file offset of every column,
+ *            every stored index (u32 key column count, u32 key columns..., u64 file offset)
+ *   data     one block of row count i32 values per column, then one block of row ids per stored index,
+ *            every block starting on a 64-byte boundary
+ *
+ * Stored indexes are the sorted indexes (see relation::getSortedIndex) the relation held when written.
+ */
+class relationFile {
+    public:
+        static void write(const relation& r, const string& path, bool storeIndexes = true);
+        static relation open(const string& path);
+
+    private:
+        /* constants */
+        static const unsigned int version = 1;
+        static const int blockAlignment = 64;
+};
+
+#endif //PROJECT_RELATIONFILE_H
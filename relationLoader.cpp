@@ -0,0 +1,187 @@
+#include <stdexcept>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "relationLoader.h"
+
+/*
+ * Creates an unnamed relation over attrs and loads the file at path into it (see loadInto).
+ */
+relation relationLoader::load(const string& path, vector<string>& attrs, char delimiter, bool skipHeader,
+                              unsigned int threadCount) {
+    relation res(attrs);
+    loadInto(res, path, delimiter, skipHeader, threadCount);
+    return res;
+}
+
+/*
+ * Appends every line of the file at path to r, in file order, as a tuple of r's attributes in column order.
+ * Parsing runs on up to threadCount threads. On a parse error r is left unchanged.
+ */
+void relationLoader::loadInto(relation& r, const string& path, char delimiter, bool skipHeader,
+                              unsigned int threadCount) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open " + path + "!");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read " + path + "!");
+    }
+
+    long long size = info.st_size;
+    void* addr = size == 0 ? nullptr : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path + "!");
+    }
+    if (size != 0) {
+        madvise(addr, size, MADV_SEQUENTIAL);
+    }
+
+    const char* begin = (const char*)addr;
+    const char* end = begin + size;
+    const char* first = begin;
+    long long headerLines = 0;
+
+    if (skipHeader && first != end) {
+        while (first != end && *first++ != '\n') {}
+        headerLines = 1;
+    }
+
+    // chunk boundaries, each moved forward to just after a line break
+    vector<const char*> bounds{first};
+    while (bounds.back() != end) {
+        const char* bound = end - bounds.back() <= chunkSize ? end : bounds.back() + chunkSize;
+        while (bound != end && bound[-1] != '\n') {
+            bound++;
+        }
+        bounds.push_back(bound);
+    }
+
+    int chunkCount = bounds.size() - 1;
+    vector<chunkResult> chunks(chunkCount);
+
+    for (chunkResult& chunk : chunks) {
+        chunk.columns.resize(r.getColumnCount());
+    }
+
+    try {
+        parallelFor(chunkCount, threadCount, [&](int chunk, int) {
+            parseChunk(bounds[chunk], bounds[chunk + 1], delimiter, chunks[chunk]);
+        });
+    } catch (...) {
+        if (addr != nullptr) {
+            munmap(addr, size);
+        }
+        throw;
+    }
+
+    if (addr != nullptr) {
+        munmap(addr, size);
+    }
+
+    // report the first error in file order; the chunks before it were parsed completely
+    long long line = headerLines + 1;
+    vector<long long> offsets{0};
+
+    for (const chunkResult& chunk : chunks) {
+        if (chunk.errorLine != -1) {
+            throw std::runtime_error(path + ":" + to_string(line + chunk.errorLine) + ": " + chunk.error);
+        }
+        line += chunk.lines;
+        offsets.push_back(offsets.back() + (chunk.columns.empty() ? 0 : chunk.columns[0].size()));
+    }
+
+    if (r.getRowCount() + offsets.back() > INT_MAX) {
+        throw std::runtime_error(path + " has too many rows!");
+    }
+
+    vector<trackedVector<int>> columns(r.getColumnCount(), trackedVector<int>(offsets.back()));
+
+    parallelFor(chunkCount, threadCount, [&](int chunk, int) {
+        for (int c = 0; c < columns.size(); c++) {
+            copy(chunks[chunk].columns[c].begin(), chunks[chunk].columns[c].end(), columns[c].begin() + offsets[chunk]);
+            trackedVector<int>().swap(chunks[chunk].columns[c]);
+        }
+    });
+
+    r.appendColumns(move(columns));
+}
+
+/*
+ * Parses the lines in [pos, end) into res.columns. Stops at the first malformed line, recording it in res.
+ */
+void relationLoader::parseChunk(const char* pos, const char* end, char delimiter, chunkResult& res) {
+    int columnCount = res.columns.size();
+
+    for (trackedVector<int>& col : res.columns) {
+        col.reserve((end - pos) / (2 * max(1, columnCount)));
+    }
+
+    while (pos != end) {
+        // empty line
+        if (*pos == '\n') {
+            pos++;
+            res.lines++;
+            continue;
+        } else if (*pos == '\r' && (pos + 1 == end || pos[1] == '\n')) {
+            pos++;
+            continue;
+        }
+
+        for (int c = 0; c < columnCount; c++) {
+            bool negative = pos != end && *pos == '-';
+            if (pos != end && (*pos == '-' || *pos == '+')) {
+                pos++;
+            }
+
+            // values are capped just above 2^32, which is out of range either way
+            const char* digits = pos;
+            long long val = 0;
+            while (pos != end && (unsigned)(*pos - '0') < 10) {
+                val = min(val * 10 + (*pos++ - '0'), 1LL << 33);
+            }
+
+            if (pos == digits) {
+                res.error = "expected an integer in field " + to_string(c + 1);
+            } else if (val > (negative ? -(long long)INT_MIN : INT_MAX)) {
+                res.error = "integer out of range in field " + to_string(c + 1);
+            } else {
+                res.columns[c].push_back(negative ? -val : val);
+
+                bool lineEnd = pos == end || *pos == '\n' || *pos == '\r';
+                if (c + 1 < columnCount && !lineEnd && *pos == delimiter) {
+                    pos++;
+                    continue;
+                } else if (c + 1 == columnCount && lineEnd) {
+                    continue;
+                }
+                res.error = c + 1 < columnCount ? "expected " + to_string(columnCount) + " fields"
+                            : *pos == delimiter ? "more than " + to_string(columnCount) + " fields"
+                            : "unexpected character in field " + to_string(c + 1);
+            }
+
+            res.errorLine = res.lines;
+            return;
+        }
+
+        if (pos != end && *pos == '\r') {
+            pos++;
+            if (pos != end && *pos != '\n') {
+                res.error = "unexpected carriage return";
+                res.errorLine = res.lines;
+                return;
+            }
+        }
+        if (pos != end) {
+            pos++;
+            res.lines++;
+        }
+    }
+}
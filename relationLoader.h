@@ -0,0 +1,39 @@
+#ifndef PROJECT_RELATIONLOADER_H
+#define PROJECT_RELATIONLOADER_H
+
+#include <string>
+#include "relation.h"
+#include "parallel.h"
+
+using namespace std;
+
+/*
+ * Bulk loader for delimited text files (CSV, TSV, ...) holding one tuple of integers per line.
+ * The file is mapped into memory and split into chunks at line boundaries, the chunks are parsed in parallel
+ * into per-chunk columns, and the columns are concatenated and appended to the relation in one block.
+ * Fields are optionally signed decimal integers, separated by exactly one delimiter; '\r' before a line break
+ * and empty lines are ignored. Parse errors are reported as std::runtime_error naming the file and line.
+ */
+class relationLoader {
+    public:
+        static relation load(const string& path, vector<string>& attrs, char delimiter = ',',
+                             bool skipHeader = false, unsigned int threadCount = defaultThreadCount());
+        static void loadInto(relation& r, const string& path, char delimiter = ',', bool skipHeader = false,
+                             unsigned int threadCount = defaultThreadCount());
+
+    private:
+        /* private structs */
+        struct chunkResult {
+            vector<trackedVector<int>> columns;
+            long long lines = 0;         // line breaks consumed by the chunk
+            long long errorLine = -1;    // line of the first error, relative to the chunk's first line
+            string error;
+        };
+
+        static void parseChunk(const char* pos, const char* end, char delimiter, chunkResult& res);
+
+        /* constants */
+        static const long long chunkSize = 1 << 24;
+};
+
+#endif //PROJECT_RELATIONLOADER_H
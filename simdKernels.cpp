@@ -0,0 +1,433 @@
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include "simdKernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(PROJECT_NO_SIMD)
+#define PROJECT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// the two halves of the Fibonacci hashing multiplier of joinHashTable::hashKey
+static const unsigned int hashLow = 0x7F4A7C15U;
+static const unsigned int hashHigh = 0x9E3779B9U;
+static const unsigned int rowMix = 0x85EBCA6BU;
+
+static atomic<int>& activeLevel() {
+    static atomic<int> l(simdKernels::getSupportedLevel());
+    return l;
+}
+
+/*
+ * Scalar kernels, also used for the tails of the vectorized ones.
+ */
+
+static inline unsigned int hashScalar(int key) {
+    unsigned long long h = (unsigned long long)(unsigned int)key * (((unsigned long long)hashHigh << 32) | hashLow);
+    return (unsigned int)(h >> 32);
+}
+
+static void gatherScalar(columnSpan col, const int* rows, int first, int count, int* out) {
+    for (int i = first; i < count; i++) {
+        out[i] = col[rows[i]];
+    }
+}
+
+static void hashKeysScalar(const int* keys, int first, int count, unsigned int* out) {
+    for (int i = first; i < count; i++) {
+        out[i] = hashScalar(keys[i]);
+    }
+}
+
+static void hashRowsScalar(const vector<columnSpan>& keys, const int* rows, int first, int count, int* out) {
+    for (int i = first; i < count; i++) {
+        unsigned int h = 0;
+
+        for (const columnSpan& col : keys) {
+            h = hashScalar(col[rows[i]] ^ (int)(h * rowMix));
+        }
+        out[i] = h;
+    }
+}
+
+static void matchKeysScalar(columnSpan a, const int* aRows, columnSpan b, const int* bRows, int first, int count,
+                            unsigned char* equal) {
+    for (int i = first; i < count; i++) {
+        equal[i] &= a[aRows[i]] == b[bRows[i]];
+    }
+}
+
+static void minMaxScalar(const int* vals, int first, int count, int& minVal, int& maxVal) {
+    for (int i = first; i < count; i++) {
+        minVal = min(minVal, vals[i]);
+        maxVal = max(maxVal, vals[i]);
+    }
+}
+
+// lo <= val <= hi as one unsigned comparison; branch-free, the index is always written and kept on a match
+static int selectRangeScalar(const int* vals, int first, int count, int lo, int hi, bool negate, int* out, int n) {
+    unsigned int width = (unsigned int)hi - (unsigned int)lo;
+
+    for (int i = first; i < count; i++) {
+        out[n] = i;
+        n += (((unsigned int)vals[i] - (unsigned int)lo <= width) != negate);
+    }
+    return n;
+}
+
+// appends the indexes first + lane of the set bits of mask to out
+static inline int appendLanes(unsigned int mask, int first, int* out, int n) {
+    while (mask != 0) {
+        out[n++] = first + __builtin_ctz(mask);
+        mask &= mask - 1;
+    }
+    return n;
+}
+
+#ifdef PROJECT_X86_SIMD
+
+/*
+ * SSE4.2 kernels, four lanes. There is no gather instruction, so rows are loaded one by one and only the
+ * arithmetic is vectorized.
+ */
+
+// (key * multiplier) >> 32 for a 64-bit multiplier, truncated to 32 bits: hi32(key * low) + key * high
+__attribute__((target("sse4.2")))
+static inline __m128i hashSse(__m128i keys) {
+    __m128i low = _mm_set1_epi32(hashLow);
+    __m128i even = _mm_srli_epi64(_mm_mul_epu32(keys, low), 32);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(keys, 32), low);
+    __m128i high = _mm_blend_epi16(even, odd, 0xCC);
+    return _mm_add_epi32(high, _mm_mullo_epi32(keys, _mm_set1_epi32(hashHigh)));
+}
+
+__attribute__((target("sse4.2")))
+static inline __m128i gatherSse(columnSpan col, const int* rows) {
+    return _mm_setr_epi32(col[rows[0]], col[rows[1]], col[rows[2]], col[rows[3]]);
+}
+
+__attribute__((target("sse4.2")))
+static void hashKeysSse(const int* keys, int count, unsigned int* out) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i k = _mm_loadu_si128((const __m128i*)(keys + i));
+        _mm_storeu_si128((__m128i*)(out + i), hashSse(k));
+    }
+    hashKeysScalar(keys, i, count, out);
+}
+
+__attribute__((target("sse4.2")))
+static void hashRowsSse(const vector<columnSpan>& keys, const int* rows, int count, int* out) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i h = _mm_setzero_si128();
+
+        for (const columnSpan& col : keys) {
+            __m128i mixed = _mm_mullo_epi32(h, _mm_set1_epi32(rowMix));
+            h = hashSse(_mm_xor_si128(gatherSse(col, rows + i), mixed));
+        }
+        _mm_storeu_si128((__m128i*)(out + i), h);
+    }
+    hashRowsScalar(keys, rows, i, count, out);
+}
+
+__attribute__((target("sse4.2")))
+static void matchKeysSse(columnSpan a, const int* aRows, columnSpan b, const int* bRows, int count,
+                         unsigned char* equal) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(gatherSse(a, aRows + i), gatherSse(b, bRows + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+
+        for (int lane = 0; lane < 4; lane++) {
+            equal[i + lane] &= (mask >> lane) & 1;
+        }
+    }
+    matchKeysScalar(a, aRows, b, bRows, i, count, equal);
+}
+
+__attribute__((target("sse4.2")))
+static void minMaxSse(const int* vals, int count, int& minVal, int& maxVal) {
+    __m128i lo = _mm_set1_epi32(INT_MAX), hi = _mm_set1_epi32(INT_MIN);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(vals + i));
+        lo = _mm_min_epi32(lo, v);
+        hi = _mm_max_epi32(hi, v);
+    }
+
+    int lows[4], highs[4];
+    _mm_storeu_si128((__m128i*)lows, lo);
+    _mm_storeu_si128((__m128i*)highs, hi);
+    for (int lane = 0; lane < 4; lane++) {
+        minVal = min(minVal, lows[lane]);
+        maxVal = max(maxVal, highs[lane]);
+    }
+    minMaxScalar(vals, i, count, minVal, maxVal);
+}
+
+__attribute__((target("sse4.2")))
+static int selectRangeSse(const int* vals, int count, int lo, int hi, bool negate, int* out) {
+    // signed comparison of the offsets from lo with the sign bit flipped is the unsigned comparison
+    __m128i sign = _mm_set1_epi32(INT_MIN);
+    __m128i low = _mm_set1_epi32(lo);
+    __m128i width = _mm_xor_si128(_mm_set1_epi32((unsigned int)hi - (unsigned int)lo), sign);
+    unsigned int flip = negate ? 0 : 0xF;
+    int i = 0, n = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i offset = _mm_xor_si128(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(vals + i)), low), sign);
+        unsigned int outside = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(offset, width)));
+        n = appendLanes(outside ^ flip, i, out, n);
+    }
+    return selectRangeScalar(vals, i, count, lo, hi, negate, out, n);
+}
+
+/*
+ * AVX2 kernels, eight lanes, with hardware gathers for row ids.
+ */
+
+__attribute__((target("avx2")))
+static inline __m256i hashAvx(__m256i keys) {
+    __m256i low = _mm256_set1_epi32(hashLow);
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(keys, low), 32);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(keys, 32), low);
+    __m256i high = _mm256_blend_epi32(even, odd, 0xAA);
+    return _mm256_add_epi32(high, _mm256_mullo_epi32(keys, _mm256_set1_epi32(hashHigh)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i gatherAvx(columnSpan col, const int* rows) {
+    return _mm256_i32gather_epi32(col.data, _mm256_loadu_si256((const __m256i*)rows), 4);
+}
+
+__attribute__((target("avx2")))
+static void gatherAvx(columnSpan col, const int* rows, int count, int* out) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(out + i), gatherAvx(col, rows + i));
+    }
+    gatherScalar(col, rows, i, count, out);
+}
+
+__attribute__((target("avx2")))
+static void hashKeysAvx(const int* keys, int count, unsigned int* out) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i k = _mm256_loadu_si256((const __m256i*)(keys + i));
+        _mm256_storeu_si256((__m256i*)(out + i), hashAvx(k));
+    }
+    hashKeysScalar(keys, i, count, out);
+}
+
+__attribute__((target("avx2")))
+static void hashRowsAvx(const vector<columnSpan>& keys, const int* rows, int count, int* out) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i h = _mm256_setzero_si256();
+
+        for (const columnSpan& col : keys) {
+            __m256i mixed = _mm256_mullo_epi32(h, _mm256_set1_epi32(rowMix));
+            h = hashAvx(_mm256_xor_si256(gatherAvx(col, rows + i), mixed));
+        }
+        _mm256_storeu_si256((__m256i*)(out + i), h);
+    }
+    hashRowsScalar(keys, rows, i, count, out);
+}
+
+__attribute__((target("avx2")))
+static void matchKeysAvx(columnSpan a, const int* aRows, columnSpan b, const int* bRows, int count,
+                         unsigned char* equal) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(gatherAvx(a, aRows + i), gatherAvx(b, bRows + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+
+        for (int lane = 0; lane < 8; lane++) {
+            equal[i + lane] &= (mask >> lane) & 1;
+        }
+    }
+    matchKeysScalar(a, aRows, b, bRows, i, count, equal);
+}
+
+__attribute__((target("avx2")))
+static void minMaxAvx(const int* vals, int count, int& minVal, int& maxVal) {
+    __m256i lo = _mm256_set1_epi32(INT_MAX), hi = _mm256_set1_epi32(INT_MIN);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(vals + i));
+        lo = _mm256_min_epi32(lo, v);
+        hi = _mm256_max_epi32(hi, v);
+    }
+
+    int lows[8], highs[8];
+    _mm256_storeu_si256((__m256i*)lows, lo);
+    _mm256_storeu_si256((__m256i*)highs, hi);
+    for (int lane = 0; lane < 8; lane++) {
+        minVal = min(minVal, lows[lane]);
+        maxVal = max(maxVal, highs[lane]);
+    }
+    minMaxScalar(vals, i, count, minVal, maxVal);
+}
+
+__attribute__((target("avx2")))
+static int selectRangeAvx(const int* vals, int count, int lo, int hi, bool negate, int* out) {
+    __m256i sign = _mm256_set1_epi32(INT_MIN);
+    __m256i low = _mm256_set1_epi32(lo);
+    __m256i width = _mm256_xor_si256(_mm256_set1_epi32((unsigned int)hi - (unsigned int)lo), sign);
+    unsigned int flip = negate ? 0 : 0xFF;
+    int i = 0, n = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i offset = _mm256_xor_si256(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(vals + i)), low), sign);
+        unsigned int outside = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(offset, width)));
+        n = appendLanes(outside ^ flip, i, out, n);
+    }
+    return selectRangeScalar(vals, i, count, lo, hi, negate, out, n);
+}
+
+#endif
+
+/*
+ * Public functions
+ */
+
+simdKernels::level simdKernels::getLevel() {
+    return (level)activeLevel().load(memory_order_relaxed);
+}
+
+/*
+ * The widest instruction set of this CPU that the kernels were compiled for.
+ */
+simdKernels::level simdKernels::getSupportedLevel() {
+#ifdef PROJECT_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return sse42;
+    }
+#endif
+    return scalar;
+}
+
+/*
+ * Restricts the kernels to level l, or to the supported level if l is wider (e.g. to compare the
+ * implementations). Affects all threads; operators running concurrently may see either level.
+ */
+void simdKernels::setLevel(level l) {
+    activeLevel().store(min(l, getSupportedLevel()), memory_order_relaxed);
+}
+
+const char* simdKernels::getLevelName(level l) {
+    switch (l) {
+        case avx2:
+            return "avx2";
+        case sse42:
+            return "sse4.2";
+        default:
+            return "scalar";
+    }
+}
+
+/*
+ * out[i] = col[rows[i]]
+ */
+void simdKernels::gather(columnSpan col, const int* rows, int count, int* out) {
+#ifdef PROJECT_X86_SIMD
+    if (getLevel() == avx2) {
+        return gatherAvx(col, rows, count, out);
+    }
+#endif
+    gatherScalar(col, rows, 0, count, out);
+}
+
+/*
+ * out[i] = joinHashTable::hashKey(keys[i])
+ */
+void simdKernels::hashKeys(const int* keys, int count, unsigned int* out) {
+#ifdef PROJECT_X86_SIMD
+    switch (getLevel()) {
+        case avx2:
+            return hashKeysAvx(keys, count, out);
+        case sse42:
+            return hashKeysSse(keys, count, out);
+        default:
+            break;
+    }
+#endif
+    hashKeysScalar(keys, 0, count, out);
+}
+
+/*
+ * out[i] = joinHashTable::hashRow(keys, rows[i])
+ */
+void simdKernels::hashRows(const vector<columnSpan>& keys, const int* rows, int count, int* out) {
+#ifdef PROJECT_X86_SIMD
+    switch (getLevel()) {
+        case avx2:
+            return hashRowsAvx(keys, rows, count, out);
+        case sse42:
+            return hashRowsSse(keys, rows, count, out);
+        default:
+            break;
+    }
+#endif
+    hashRowsScalar(keys, rows, 0, count, out);
+}
+
+/*
+ * Clears equal[i] unless a[aRows[i]] == b[bRows[i]]; called once per key column to compare composite keys.
+ */
+void simdKernels::matchKeys(columnSpan a, const int* aRows, columnSpan b, const int* bRows, int count,
+                            unsigned char* equal) {
+#ifdef PROJECT_X86_SIMD
+    switch (getLevel()) {
+        case avx2:
+            return matchKeysAvx(a, aRows, b, bRows, count, equal);
+        case sse42:
+            return matchKeysSse(a, aRows, b, bRows, count, equal);
+        default:
+            break;
+    }
+#endif
+    matchKeysScalar(a, aRows, b, bRows, 0, count, equal);
+}
+
+/*
+ * Smallest and largest value of col; INT_MAX and INT_MIN for an empty column.
+ */
+void simdKernels::minMax(columnSpan col, int& minVal, int& maxVal) {
+    minVal = INT_MAX;
+    maxVal = INT_MIN;
+#ifdef PROJECT_X86_SIMD
+    switch (getLevel()) {
+        case avx2:
+            return minMaxAvx(col.data, col.size, minVal, maxVal);
+        case sse42:
+            return minMaxSse(col.data, col.size, minVal, maxVal);
+        default:
+            break;
+    }
+#endif
+    minMaxScalar(col.data, 0, col.size, minVal, maxVal);
+}
+
+/*
+ * Writes the indexes i with lo <= vals[i] <= hi (or, if negate is set, the others) to out, in ascending order,
+ * and returns their number. Requires lo <= hi; out must have room for count indexes.
+ */
+int simdKernels::selectRange(const int* vals, int count, int lo, int hi, bool negate, int* out) {
+#ifdef PROJECT_X86_SIMD
+    switch (getLevel()) {
+        case avx2:
+            return selectRangeAvx(vals, count, lo, hi, negate, out);
+        case sse42:
+            return selectRangeSse(vals, count, lo, hi, negate, out);
+        default:
+            break;
+    }
+#endif
+    return selectRangeScalar(vals, 0, count, lo, hi, negate, out, 0);
+}
@@ -0,0 +1,34 @@
+#ifndef PROJECT_SIMDKERNELS_H
+#define PROJECT_SIMDKERNELS_H
+
+#include <vector>
+#include "columnSpan.h"
+
+using namespace std;
+
+/*
+ * Batch kernels for the hot loops of hash joins and semi-joins, each with an AVX2, an SSE4.2 and a scalar
+ * implementation. The widest instruction set the CPU supports is chosen at runtime (via CPUID) on first use;
+ * every level computes exactly the same results. Building with PROJECT_NO_SIMD defined, or for a non-x86
+ * target, leaves only the scalar code.
+ * Batches are given as arrays of row ids into the columns, so views and partitions are handled alike.
+ */
+class simdKernels {
+    public:
+        enum level { scalar, sse42, avx2 };
+
+        static level getLevel();
+        static level getSupportedLevel();
+        static void setLevel(level l);
+        static const char* getLevelName(level l);
+
+        static void gather(columnSpan col, const int* rows, int count, int* out);
+        static void hashKeys(const int* keys, int count, unsigned int* out);
+        static void hashRows(const vector<columnSpan>& keys, const int* rows, int count, int* out);
+        static void matchKeys(columnSpan a, const int* aRows, columnSpan b, const int* bRows, int count,
+                              unsigned char* equal);
+        static void minMax(columnSpan col, int& minVal, int& maxVal);
+        static int selectRange(const int* vals, int count, int lo, int hi, bool negate, int* out);
+};
+
+#endif //PROJECT_SIMDKERNELS_H